@@ -23,7 +23,6 @@
 #endif
 #include <stdio.h>
 #include <string.h>
-#include "../../editor.h"
 #include "armv7.h"
 
 #if defined _MSC_VER
@@ -80,9 +79,9 @@ static const char *register_name(int reg)
 }
 
 
-static const char *special_register(int reg, int mask)
+static const char *special_register(ARMSTATE *state, int reg, int mask)
 {
-  static char field[16];
+  char *field = state->field;
 
   switch (reg) {
   case 0x00:    strcpy(field, "APSR");    break;
@@ -99,7 +98,7 @@ static const char *special_register(int reg, int mask)
   case 0x12:    strcpy(field, "BASEPRI_MAX");    break;
   case 0x13:    strcpy(field, "FAULTMASK");    break;
   case 0x14:    strcpy(field, "CONTROL");    break;
-  default:    assert(0);    strcpy(field, "?");
+  default:    strcpy(field, "?");   /* reserved SYSm value */
   }
 
   if (reg < 5) {
@@ -888,9 +887,9 @@ static int32_t expand_mod_imm(int imm1, int imm3, int imm8)
 }
 
 /* helper function, for expandion of immediate shift */
-static const char *decode_imm_shift(int type, int count)
+static const char *decode_imm_shift(ARMSTATE *state, int type, int count)
 {
-  static char field[16];
+  char *field = state->field;
   switch (type) {
   case 0:
     if (count == 0)
@@ -1030,7 +1029,7 @@ static bool thumb2_constshift(ARMSTATE *state, uint32_t instr)
     if ((shifttype != 0 && shifttype != 3) || imm != 0)
       sprintf(tail(state->text), ", #%d", imm);
   } else if (shifttype != 0 || imm != 0) {
-      sprintf(tail(state->text), ", %s", decode_imm_shift(shifttype, imm));
+      sprintf(tail(state->text), ", %s", decode_imm_shift(state, shifttype, imm));
   }
 
   state->size = 4;
@@ -1419,7 +1418,7 @@ static bool thumb2_imm_br_misc(ARMSTATE *state, uint32_t instr)
         strcpy(state->text, "msr");
         add_it_cond(state, 0);
         padinstr(state->text);
-        sprintf(tail(state->text), "%s, %s", special_register(instr & 0xff, FIELD(instr, 8, 4)),
+        sprintf(tail(state->text), "%s, %s", special_register(state, instr & 0xff, FIELD(instr, 8, 4)),
                 register_name(FIELD(instr, 16, 4)));
         break;
       case 1:
@@ -1477,7 +1476,7 @@ static bool thumb2_imm_br_misc(ARMSTATE *state, uint32_t instr)
         add_it_cond(state, 0);
         padinstr(state->text);
         sprintf(tail(state->text), "%s, %s", register_name(FIELD(instr, 8, 4)),
-                special_register(instr & 0xff, FIELD(instr, 8, 4)));
+                special_register(state, instr & 0xff, FIELD(instr, 8, 4)));
         break;
       }
     }
@@ -1649,7 +1648,7 @@ static bool thumb2_imm_br_misc(ARMSTATE *state, uint32_t instr)
                 register_name(Rn));
         int shifttype = BIT_SET(instr, 21) ? 2 : 0;
         if (shifttype != 0 || lsb != 0)
-          sprintf(tail(state->text), ", %s", decode_imm_shift(shifttype, lsb));
+          sprintf(tail(state->text), ", %s", decode_imm_shift(state, shifttype, lsb));
         break;
       case 2:
       case 6:
@@ -2056,7 +2055,7 @@ static bool thumb_is_32bit(uint16_t w)
 }
 
 
-static const char *arm_opcode_name(unsigned opc, int variant, unsigned opc2)
+static const char *arm_opcode_name(ARMSTATE *state, unsigned opc, int variant, unsigned opc2)
 {
   static const char *mnemonics[] = {
     "and", "eor", "sub", "rsb", "add", "adc", "sbc", "rsc",
@@ -2064,7 +2063,7 @@ static const char *arm_opcode_name(unsigned opc, int variant, unsigned opc2)
   };
   assert(opc < sizearray(mnemonics));
   if (opc >= 8 && opc < 12 && variant != 0) {
-    static char field[10];
+    char *field = state->field;
     field[0] = '\0';
     switch (variant) {
     case 1:
@@ -2134,7 +2133,8 @@ static const char *arm_opcode_name(unsigned opc, int variant, unsigned opc2)
     default:
       assert(0);  /* this case should not occur (invalid instruction) */
     }
-    assert(strlen(field) > 0);
+    if (field[0] == '\0')
+      strcpy(field, "(bad)");  /* unallocated encoding in the miscellaneous space */
     return field;
   }
   return mnemonics[opc];
@@ -2153,9 +2153,8 @@ static bool arm_dataproc_imsh(ARMSTATE *state, uint32_t instr)
 {
   /* xxxx 000x xxxx xxxx : xxxx xxxx xxx0 xxxx - data processing immediate shift */
   int cond = FIELD(instr, 28, 4);
-  assert(cond != 15); /* should have been handled by arm_unconditional() */
   if (cond == 15)
-    return false;
+    return false; /* not claimed by arm_unconditional(), so not valid */
 
   int shifttype = FIELD(instr, 5, 2);
   int shiftcount = FIELD(instr, 7, 5);
@@ -2163,7 +2162,7 @@ static bool arm_dataproc_imsh(ARMSTATE *state, uint32_t instr)
   if (opc == 13 && (shifttype != 0 || shiftcount != 0))
     strcpy(state->text, shift_type(shifttype)); /* preferred syntax */
   else
-    strcpy(state->text, arm_opcode_name(opc, BIT_CLR(instr, 20), FIELD(instr, 5, 3)));
+    strcpy(state->text, arm_opcode_name(state, opc, BIT_CLR(instr, 20), FIELD(instr, 5, 3)));
   if (strlen(state->text) == 0)
     return false;
   add_condition(state, cond);
@@ -2224,7 +2223,7 @@ static bool arm_dataproc_imsh(ARMSTATE *state, uint32_t instr)
       if (opc == 13)
         sprintf(tail(state->text), ", #%d", shiftcount);
       else
-        sprintf(tail(state->text), ", %s", decode_imm_shift(shifttype, shiftcount));
+        sprintf(tail(state->text), ", %s", decode_imm_shift(state, shifttype, shiftcount));
     }
   }
 
@@ -2235,12 +2234,11 @@ static bool arm_dataproc_rxsh(ARMSTATE *state, uint32_t instr)
 {
   /* xxxx 000x xxxx xxxx : xxxx xxxx 0xx1 xxxx - data processing register shift */
   int cond = FIELD(instr, 28, 4);
-  assert(cond != 15); /* should have been handled by arm_unconditional() */
   if (cond == 15)
-    return false;
+    return false; /* not claimed by arm_unconditional(), so not valid */
 
   int opc = FIELD(instr, 21, 4);
-  strcpy(state->text, arm_opcode_name(opc, 2*BIT_CLR(instr, 20), FIELD(instr, 5, 3)));
+  strcpy(state->text, arm_opcode_name(state, opc, 2*BIT_CLR(instr, 20), FIELD(instr, 5, 3)));
   if (strlen(state->text) == 0)
     return false;
   add_condition(state, cond);
@@ -2404,7 +2402,7 @@ static bool arm_dataproc_imm(ARMSTATE *state, uint32_t instr)
     return false;
 
   int opc = FIELD(instr, 21, 4);
-  strcpy(state->text, arm_opcode_name(opc, 4*BIT_CLR(instr, 20), FIELD(instr, 5, 3)));
+  strcpy(state->text, arm_opcode_name(state, opc, 4*BIT_CLR(instr, 20), FIELD(instr, 5, 3)));
   if (strlen(state->text) == 0)
     return false;
   add_condition(state, cond);
@@ -2490,7 +2488,7 @@ static bool arm_loadstor_reg(ARMSTATE *state, uint32_t instr)
   int shifttype = FIELD(instr, 5, 2);
   int shiftcount = FIELD(instr, 7, 5);
   if (shifttype != 0 || shiftcount != 0)
-    sprintf(tail(state->text), ", %s", decode_imm_shift(shifttype, shiftcount));
+    sprintf(tail(state->text), ", %s", decode_imm_shift(state, shifttype, shiftcount));
   strcat(state->text, "]");
   return true;
 }
@@ -2877,7 +2875,7 @@ static bool arm_unconditional(ARMSTATE *state, uint32_t instr)
       int shifttype = FIELD(instr, 5, 2);
       int shiftcount = FIELD(instr, 7, 5);
       if (shifttype != 0 || shiftcount != 0)
-        sprintf(tail(state->text), ", %s", decode_imm_shift(shifttype, shiftcount));
+        sprintf(tail(state->text), ", %s", decode_imm_shift(state, shifttype, shiftcount));
       strcat(state->text, "]");
     }
     return true;
@@ -3511,19 +3509,122 @@ bool disasm_buffer(ARMSTATE *state, const uint8_t *buffer, size_t buffersize,
   return true;
 }
 
-static bool disasm_callback(uint32_t address, const char *text, void *outbuf)
+struct decode_call {
+  ARMSTATE *state;
+  char *outbuf;
+};
+
+static bool disasm_callback(uint32_t address, const char *text, void *user)
 {
-  disasm_clear_codepool(&arm);
-  sprintf(outbuf, "%s", text);
+  struct decode_call *call = user;
+  disasm_clear_codepool(call->state);
+  sprintf(call->outbuf, "%s", text);
   return true;
 }
 
-char *decodeARM32(long unsigned int start, char *outbuf, int *lendis, long unsigned int out)
+static int32_t sign_extend(uint32_t value, int bits)
+{
+  uint32_t m = 1u << (bits - 1);
+  value &= (1u << bits) - 1;
+  return (int32_t)((value ^ m) - m);
+}
+
+/* control flow of the instruction at pc, from its encoding alone */
+static int arm_flow(const uint8_t *data, uint32_t pc, bool thumb, int size, uint64_t *target)
+{
+  *target = DASM_NO_TARGET;
+  if (!thumb) {
+    uint32_t w = data[0] | data[1] << 8 | data[2] << 16 | (uint32_t)data[3] << 24;
+    uint32_t cond = w >> 28;
+    if ((w & 0x0E000000) == 0x0A000000) {
+      if (cond == 0xF) {  /* BLX label */
+        *target = (uint32_t)(pc + 8 + (sign_extend(w, 24) << 2) + ((w >> 23) & 2));
+        return DASM_FLOW_CALL;
+      }
+      *target = (uint32_t)(pc + 8 + (sign_extend(w, 24) << 2));
+      if (w & 0x01000000)
+        return DASM_FLOW_CALL;
+      return cond == 0xE ? DASM_FLOW_JUMP : DASM_FLOW_BRANCH;
+    }
+    if ((w & 0x0FFFFFF0) == 0x012FFF10)     /* BX Rm */
+      return (w & 0xF) == 14 ? DASM_FLOW_RET : DASM_FLOW_JUMP;
+    if ((w & 0x0FFFFFF0) == 0x012FFF30)     /* BLX Rm */
+      return DASM_FLOW_CALL;
+    if ((w & 0x0FFFFFFF) == 0x01A0F00E)     /* MOV pc, lr */
+      return DASM_FLOW_RET;
+    if ((w & 0x0E108000) == 0x08108000)     /* LDM with pc */
+      return ((w >> 16) & 0xF) == 13 ? DASM_FLOW_RET : DASM_FLOW_JUMP;
+    if ((w & 0x0C10F000) == 0x0410F000)     /* LDR pc */
+      return ((w >> 16) & 0xF) == 13 ? DASM_FLOW_RET : DASM_FLOW_JUMP;
+    return DASM_FLOW_NEXT;
+  }
+
+  uint32_t h = data[0] | data[1] << 8;
+  if (size == 4) {
+    uint32_t h2 = data[2] | data[3] << 8;
+    uint32_t s = (h >> 10) & 1, j1 = (h2 >> 13) & 1, j2 = (h2 >> 11) & 1;
+    if ((h & 0xF800) != 0xF000 || !(h2 & 0x8000))
+      return DASM_FLOW_NEXT;
+    if (h2 & 0x1000 || (h2 & 0xD000) == 0xC000) {  /* B.W, BL, BLX */
+      uint32_t i1 = ~(j1 ^ s) & 1, i2 = ~(j2 ^ s) & 1;
+      int32_t imm = sign_extend(s << 24 | i1 << 23 | i2 << 22 | (h & 0x3FF) << 12 | (h2 & 0x7FF) << 1, 25);
+      if ((h2 & 0xD000) == 0xC000) {
+        *target = (uint32_t)(((pc + 4) & ~3u) + imm);
+        return DASM_FLOW_CALL;
+      }
+      *target = (uint32_t)(pc + 4 + imm);
+      return (h2 & 0x4000) ? DASM_FLOW_CALL : DASM_FLOW_JUMP;
+    }
+    if (((h >> 6) & 0xF) < 0xE) {                   /* B<c>.W */
+      int32_t imm = sign_extend(s << 20 | j2 << 19 | j1 << 18 | (h & 0x3F) << 12 | (h2 & 0x7FF) << 1, 21);
+      *target = (uint32_t)(pc + 4 + imm);
+      return DASM_FLOW_BRANCH;
+    }
+    return DASM_FLOW_NEXT;
+  }
+  if ((h & 0xF000) == 0xD000 && ((h >> 8) & 0xF) < 0xE) {
+    *target = (uint32_t)(pc + 4 + (sign_extend(h, 8) << 1));
+    return DASM_FLOW_BRANCH;
+  }
+  if ((h & 0xF800) == 0xE000) {
+    *target = (uint32_t)(pc + 4 + (sign_extend(h, 11) << 1));
+    return DASM_FLOW_JUMP;
+  }
+  if ((h & 0xF500) == 0xB100) {                     /* CBZ, CBNZ */
+    *target = (uint32_t)(pc + 4 + (((h >> 9) & 1) << 6 | ((h >> 3) & 0x1F) << 1));
+    return DASM_FLOW_BRANCH;
+  }
+  if ((h & 0xFF87) == 0x4700)                       /* BX Rm */
+    return ((h >> 3) & 0xF) == 14 ? DASM_FLOW_RET : DASM_FLOW_JUMP;
+  if ((h & 0xFF87) == 0x4780)                       /* BLX Rm */
+    return DASM_FLOW_CALL;
+  if ((h & 0xFF00) == 0xBD00)                       /* POP {..., pc} */
+    return DASM_FLOW_RET;
+  return DASM_FLOW_NEXT;
+}
+
+int decodeARM32(const struct dasm_ctx *ctx, const uint8_t *data, uint64_t remaining, uint64_t offset, char *text, struct dasm_insn *insn)
 {
-    struct editor *e = editor();
+    ARMSTATE arm;
+    struct decode_call call = { &arm, text };
+    bool thumb = ctx->seg_size < 32;
+    int size = thumb && !(remaining >= 2 && thumb_is_32bit(data[0] | data[1] << 8)) ? 2 : 4;
+    if (remaining < (uint64_t)size)
+        return dasm_truncated(data, remaining, size, text, insn);
     disasm_init(&arm, 0);
-    disasm_address(&arm, start);
-    disasm_buffer(&arm, (const uint8_t *)start, 4, e->seg_size < 32 ? ARMMODE_THUMB : ARMMODE_ARM, disasm_callback, outbuf);
-    *lendis = arm.size;
+    disasm_address(&arm, offset);
+    disasm_buffer(&arm, data, remaining < 4 ? remaining : 4, thumb ? ARMMODE_THUMB : ARMMODE_ARM, disasm_callback, &call);
+    size = arm.size ? arm.size : (thumb ? 2 : 4);
     disasm_cleanup(&arm);
-}
\ No newline at end of file
+    if (insn) {
+        uint64_t target;
+        int flow = arm_flow(data, (uint32_t)offset, thumb, size, &target);
+        dasm_insn_text(insn, text, flow, target);
+        insn->length = size;
+    }
+    return size;
+}
+
+const struct be_decoder be_decoder_arm32 = {
+    "arm32", NULL, decodeARM32, dasm_decode_batch, 4, 2
+};
@@ -21,6 +21,8 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "../../dasm/decoder.h"
+
 
 typedef struct ARMSYMBOL {
   const char *name;   /**< symbol name, but may be NULL if unknown */
@@ -42,6 +44,7 @@ typedef struct ARMDATA {
 
 typedef struct {
   char text[128];     /**< decoded instruction (optionally prefixed with address/hex values) */
+  char field[16];     /**< scratch for operand helpers */
   uint32_t address;   /**< address (used for branch labels) */
   uint16_t size;      /**< size of the instruction in bytes */
 
@@ -80,7 +83,6 @@ enum {
 
 typedef bool (*DISASM_CALLBACK)(uint32_t address, const char *text, void *user);
 
-extern ARMSTATE arm;
 
 void disasm_init(ARMSTATE *state, int flags);
 void disasm_cleanup(ARMSTATE *state);
@@ -94,7 +96,9 @@ const char *disasm_result(ARMSTATE *state, int *size);
 bool disasm_buffer(ARMSTATE *state, const uint8_t *buffer, size_t buffersize, int mode, DISASM_CALLBACK callback, void *user);
 bool disasm_literals(ARMSTATE *state, const uint8_t *block, size_t blocksize, uint32_t address);
 
-char *decodeARM32(long unsigned int start, char *outbuf, int *outlen, long unsigned int offset0);
+int decodeARM32(const struct dasm_ctx *ctx, const uint8_t *data, uint64_t remaining, uint64_t offset, char *text, struct dasm_insn *insn);
+
+extern const struct be_decoder be_decoder_arm32;
 
 #endif /* _ARMDISASM_H */
 
@@ -15,19 +15,83 @@
 #include "DataProcessingRegister.h"
 #include "LoadsAndStores.h"
 
-unsigned int * opcode = NULL;
-struct ad_insn *insn = NULL;
+// No state outside the call: batch listings decode on several threads.
 
-char *decodeARM64(unsigned long int start, char *outbuf, int *lendis, unsigned long int offset0)
+static void describe(const struct ad_insn *in, struct dasm_insn *insn)
 {
-     *lendis = 4;
-     opcode = (unsigned int *)start;
-     ArmadilloDisassemble(*opcode, (unsigned long)opcode, &insn);
-     memcpy(outbuf,insn->decoded,strlen(insn->decoded)+1);
-     ArmadilloDone(&insn);
-     return outbuf;
+    int flow = DASM_FLOW_NEXT;
+    uint64_t target = DASM_NO_TARGET;
+    const struct ad_operand *last = in->num_operands ? &in->operands[in->num_operands - 1] : NULL;
+
+    switch(in->instr_id){
+        case AD_INSTR_B:
+            flow = in->cc == AD_NONE ? DASM_FLOW_JUMP : DASM_FLOW_BRANCH;
+            break;
+        case AD_INSTR_BL:
+            flow = DASM_FLOW_CALL;
+            break;
+        case AD_INSTR_CBZ: case AD_INSTR_CBNZ:
+        case AD_INSTR_TBZ: case AD_INSTR_TBNZ:
+            flow = DASM_FLOW_BRANCH;
+            break;
+        case AD_INSTR_BR: case AD_INSTR_BRAA: case AD_INSTR_BRAAZ:
+        case AD_INSTR_BRAB: case AD_INSTR_BRABZ:
+            flow = DASM_FLOW_JUMP;
+            last = NULL;
+            break;
+        case AD_INSTR_BLR: case AD_INSTR_BLRAA: case AD_INSTR_BLRAAZ:
+        case AD_INSTR_BLRAB: case AD_INSTR_BLRABZ:
+            flow = DASM_FLOW_CALL;
+            last = NULL;
+            break;
+        case AD_INSTR_RET: case AD_INSTR_RETAA: case AD_INSTR_RETAB:
+        case AD_INSTR_ERET: case AD_INSTR_ERETAA: case AD_INSTR_ERETAB:
+            flow = DASM_FLOW_RET;
+            last = NULL;
+            break;
+        default:
+            last = NULL;
+            break;
+    }
+    if(last && last->type == AD_OP_IMM)
+        target = (uint64_t)last->op_imm.bits;
+
+    dasm_insn_text(insn, in->decoded, flow, target);
+    insn->operands = in->num_operands < DASM_OPERANDS ? in->num_operands : DASM_OPERANDS;
+    memset(insn->operand, DASM_OPND_NONE, sizeof(insn->operand));
+    for(int k = 0; k < insn->operands; k++){
+        switch(in->operands[k].type){
+            case AD_OP_REG: insn->operand[k] = DASM_OPND_REG; break;
+            case AD_OP_MEM: insn->operand[k] = DASM_OPND_MEM; break;
+            default:        insn->operand[k] = DASM_OPND_IMM; break;
+        }
+    }
+    if(target != DASM_NO_TARGET)
+        insn->operand[insn->operands - 1] = DASM_OPND_REL;
+}
+
+int decodeARM64(const struct dasm_ctx *ctx, const uint8_t *data, uint64_t remaining, uint64_t offset,
+        char *text, struct dasm_insn *insn)
+{
+     struct ad_insn *in = NULL;
+     unsigned int opcode;
+     if(remaining < 4) return dasm_truncated(data, remaining, 4, text, insn);
+     memcpy(&opcode, data, 4);
+     int failed = ArmadilloDisassemble(opcode, offset, &in);
+     memcpy(text,in->decoded,strlen(in->decoded)+1);
+     if(insn){
+         if(failed) dasm_insn_text(insn, text, DASM_FLOW_NEXT, DASM_NO_TARGET);
+         else describe(in, insn);
+         insn->length = 4;
+     }
+     ArmadilloDone(&in);
+     return 4;
 }
 
+const struct be_decoder be_decoder_arm64 = {
+    "arm64", NULL, decodeARM64, dasm_decode_batch, 4, 4
+};
+
 static int _ArmadilloDisassemble(struct instruction *i,
         struct ad_insn **_out){
     struct ad_insn *out = *_out;
@@ -3,9 +3,13 @@
 
 #include <stdint.h>
 #include "adefs.h"
+#include "../../dasm/decoder.h"
 
 int ArmadilloDisassemble(unsigned int opcode, unsigned long PC, struct ad_insn **out);
 int ArmadilloDone(struct ad_insn **insn);
-char *decodeARM64(unsigned long int start, char *outbuf, int *outlen, unsigned long int offset0);
+int decodeARM64(const struct dasm_ctx *ctx, const uint8_t *data, uint64_t remaining, uint64_t offset,
+        char *text, struct dasm_insn *insn);
+
+extern const struct be_decoder be_decoder_arm64;
 
 #endif
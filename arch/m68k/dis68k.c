@@ -13,6 +13,8 @@
 #include <ctype.h>
 #include <string.h>
 
+#include "m68k.h"
+
 struct OpcodeDetails {
 	uint16_t and;
 	uint16_t xor;
@@ -43,9 +45,17 @@ const struct OpcodeDetails optab[88] = {
 	{0xFFF0,0x4E40}, {0xFFFF,0x4E76}, {0xFF00,0x4A00}, {0xFFF8,0x4E58}
 };
 
-unsigned long int address, romstart;
+unsigned long int romstart;
 bool rawmode = false;
 
+// Read position of one decode: address walks the host bytes, pcbias maps
+// it back to the file offset printed in operands.
+
+struct cursor {
+	unsigned long int address;
+	long int pcbias;
+};
+
 struct MapEntry {
 	uint32_t start;
 	uint32_t end;
@@ -72,25 +82,25 @@ const char size_arr[3] = {'B','W','L'};
 
 
 /*!
-	Gets and echoes the next byte from stdin and increments the global @c address;
+	Gets and echoes the next byte from stdin and increments @c c->address;
 	if stdin is exhausted, prints an error and causes the program to exit with
 	code EXIT_FAILURE.
 */
-unsigned int getbyte() {
-	uint8_t byte = *((uint8_t *)address);
-	++ address;
+unsigned int getbyte(struct cursor *c) {
+	uint8_t byte = *((uint8_t *)c->address);
+	++ c->address;
 	return byte;
 }
 
 /*!
-	Gets and echoes the next word from stdin and increments the global @c address twice;
+	Gets and echoes the next word from stdin and increments @c c->address twice;
 	if stdin is exhausted, prints an error and causes the program to exit with
 	code EXIT_FAILURE.
 */
-uint16_t getword() {
-        uint16_t word = (uint16_t)*(int *)address;
-        address += 2;
-        return word;
+uint16_t getword(struct cursor *c) {
+        const uint8_t *p = (const uint8_t *)c->address;
+        c->address += 2;
+        return (uint16_t)(p[0] | p[1] << 8);
 }
 
 /*!
@@ -99,7 +109,7 @@ uint16_t getword() {
 	@param mode 0 to 12, indicating addressing mode.
 	@param size 0 = byte, 1 = word, 2 = long.
 */
-void sprintmode(unsigned int mode, unsigned int reg, unsigned int size, char *out_s) {
+void sprintmode(struct cursor *c, unsigned int mode, unsigned int reg, unsigned int size, char *out_s) {
 	const char ir[2] = {'W','L'}; /* for mode 6 */
 
 	switch(mode) {
@@ -110,12 +120,12 @@ void sprintmode(unsigned int mode, unsigned int reg, unsigned int size, char *ou
 		case 4  : sprintf(out_s, "-(A%i)", reg);	break;
 		case 5  : /* reg + disp */
 		case 9  : { /* pcr + disp */
-			int32_t displacement = (int32_t) getword();
+			int32_t displacement = (int32_t) getword(c);
 			if (displacement >= 32768) displacement -= 65536;
 			if (mode == 5) {
 				sprintf(out_s, "%+i(A%i)", displacement, reg);
 			} else {
-				const uint32_t ldata = address - 2 + displacement;
+				const uint32_t ldata = c->address + c->pcbias - 2 + displacement;
 				if (!rawmode) {
 					sprintf(out_s, "%+i(PC) {$%08u}", displacement, ldata);
 				} else {
@@ -125,7 +135,7 @@ void sprintmode(unsigned int mode, unsigned int reg, unsigned int size, char *ou
 		} break;
 		case 6  : /* Areg with index + disp */
 		case 10 : {/* PC with index + disp */
-			const int data = getword(); /* index and displacement data */
+			const int data = getword(c); /* index and displacement data */
 
 			int displacement = (data & 0x00FF);
 			if (displacement >= 128) displacement -= 256;
@@ -149,22 +159,22 @@ void sprintmode(unsigned int mode, unsigned int reg, unsigned int size, char *ou
 			}
 		} break;
 		case 7  :
-			sprintf(out_s, "$0000%04x", getword());
+			sprintf(out_s, "$0000%04x", getword(c));
 			break;
 		case 8  : {
-			const int data1 = getword();
-			const int data2 = getword();
+			const int data1 = getword(c);
+			const int data2 = getword(c);
 			sprintf(out_s, "$%04x%04x", data1, data2);
 		} break;
 		case 11 : {
-			const int data1 = getword();
+			const int data1 = getword(c);
 			switch(size) {
 				case 0 : sprintf(out_s, "#$%02x", (data1 & 0x00FF));
 					break;
 				case 1 : sprintf(out_s, "#$%04x", data1);
 					break;
 				case 2 : {
-					const int data2 = getword();
+					const int data2 = getword(c);
 					sprintf(out_s, "#$%04x%04x", data1, data2);
 				} break;
 			}
@@ -194,14 +204,50 @@ int getmode(int instruction) {
 	return mode;
 }
 
-void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned long int offset0) {
-	unsigned long int end = start + 10;
-	address = start;
+/*!
+	Control flow of the instruction at @c data, read in the same word order
+	as getword. Targets are known for branches and for JMP/JSR to absolute
+	or PC-relative operands.
+*/
+static int flow(const uint8_t *data, uint64_t pc, uint64_t *target) {
+	#define WORD(k) ((uint16_t)(data[2 * (k)] | data[2 * (k) + 1] << 8))
+	const uint16_t word = WORD(0);
+	*target = DASM_NO_TARGET;
+
+	if (word == 0x4E75 || word == 0x4E73 || word == 0x4E77) return DASM_FLOW_RET;
+	if ((word & 0xFF80) == 0x4E80) { /* JSR, JMP */
+		const int mode = (word & 0x0038) >> 3, reg = word & 0x0007;
+		if (mode == 7 && reg == 0) *target = (uint64_t)(int16_t)WORD(1);
+		else if (mode == 7 && reg == 1) *target = (uint32_t)(WORD(1) << 16 | WORD(2));
+		else if (mode == 7 && reg == 2) *target = pc + 2 + (int16_t)WORD(1);
+		return (word & 0x0040) ? DASM_FLOW_JUMP : DASM_FLOW_CALL;
+	}
+	if ((word & 0xF000) == 0x6000) { /* Bcc, BRA, BSR */
+		const int cond = (word & 0x0F00) >> 8;
+		int32_t disp = (int8_t)(word & 0x00FF);
+		if (disp == 0) disp = (int16_t)WORD(1);
+		else if (disp == -1) disp = (int32_t)(WORD(1) << 16 | WORD(2));
+		*target = pc + 2 + disp;
+		return cond == 0 ? DASM_FLOW_JUMP : cond == 1 ? DASM_FLOW_CALL : DASM_FLOW_BRANCH;
+	}
+	if ((word & 0xF0F8) == 0x50C8) { /* DBcc */
+		*target = pc + 2 + (int16_t)WORD(1);
+		return DASM_FLOW_BRANCH;
+	}
+	return DASM_FLOW_NEXT;
+	#undef WORD
+}
+
+int decodeM68K(const struct dasm_ctx *ctx, const uint8_t *data, uint64_t remaining, uint64_t offset, char *outbuf, struct dasm_insn *insn) {
+	uint8_t pad[10];
+	data = dasm_pad(pad, sizeof(pad), data, remaining);
+	unsigned long int start = (unsigned long int)data, end = start + sizeof(pad);
+	struct cursor cur = { start, offset - start }, *c = &cur;
 	char operand_s[100];
 
-	while ((address < end)) {
-		const uint32_t start_address = address;
-		const uint16_t word = getword();
+	while ((c->address < end)) {
+		const uint32_t start_address = c->address;
+		const uint16_t word = getword(c);
 
 		bool decoded = false;
 
@@ -263,7 +309,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 						}
 
 						char dest_s[50];
-						sprintmode(dmode, dreg, size, dest_s);
+						sprintmode(c, dmode, dreg, size, dest_s);
 
 						const int sreg = (word & 0x0E00) >> 9;
 						char source_s[50];
@@ -289,7 +335,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 								break;
 						}
 						char source_s[50];
-						sprintmode(smode, sreg, size, source_s);
+						sprintmode(c, smode, sreg, size, source_s);
 						sprintf(operand_s, "%s,A%i", source_s, sreg);
 						decoded = true;
 					} break;
@@ -325,7 +371,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 								break;
 						}
 
-						const int data = getword();
+						const int data = getword(c);
 						char source_s[50];
 						switch(size) {
 							case 0 : sprintf(source_s, "#$%02X", (data & 0x00FF));
@@ -333,7 +379,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 							case 1 : sprintf(source_s, "#$%04X", data);
 								break;
 							case 2 :
-								sprintf(source_s, "#$%04X%04X", data, getword());
+								sprintf(source_s, "#$%04X%04X", data, getword(c));
 								break;
 						}
 
@@ -341,7 +387,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 						if (dmode == 11) {
 							sprintf(dest_s, "SR");
 						} else {
-							sprintmode(dmode, dreg, size, dest_s);
+							sprintmode(c, dmode, dreg, size, dest_s);
 						}
 						sprintf(operand_s, "%s,%s", source_s, dest_s);
 						decoded = true;
@@ -362,7 +408,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 							sprintf(opcode_s,"SUBQ.%c",size_arr[size]);
 						}
 						char dest_s[50];
-						sprintmode(dmode, dreg, size, dest_s);
+						sprintmode(c, dmode, dreg, size, dest_s);
 						const int count = (word & 0x0E00) >> 9;
 						sprintf(operand_s, "#%i,%s", count ? count : 8, dest_s);
 						decoded = true;
@@ -464,7 +510,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 							case 70 : sprintf(opcode_s,"ROXR");
 								break;
 						}
-						sprintmode(dmode, dreg, 0, operand_s);
+						sprintmode(c, dmode, dreg, 0, operand_s);
 						decoded = true;
 					} break;
 					case 13 : {/* Bcc */
@@ -475,15 +521,15 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 						if (offset != 0) {
 							if (offset >= 128) offset -= 256;
 							if (!rawmode) {
-								sprintf(operand_s, "$%08x", address + offset);
+								sprintf(operand_s, "$%08x", c->address + c->pcbias + offset);
 							} else {
 								sprintf(operand_s, "*%+d", offset);
 							}
 						} else {
-							offset = getword();
+							offset = getword(c);
 							if (offset >= 32768l) offset -= 65536l;
 							if (!rawmode) {
-								sprintf(operand_s, "$%08x" , address - 2 + offset);
+								sprintf(operand_s, "$%08x" , c->address + c->pcbias - 2 + offset);
 							} else {
 								sprintf(operand_s, "*%+d", offset);
 							}
@@ -514,7 +560,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 								break;
 							case 15 : {/* BCHG_IMM */
 								sprintf(opcode_s, "BCHG");
-								const int data = getword() & 0x002F;
+								const int data = getword(c) & 0x002F;
 								sprintf(source_s, "#%i", data);
 							} break;
 							case 16 : /* BCLR_DREG */
@@ -523,7 +569,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 								break;
 							case 17 : {/* BCLR_IMM */
 								sprintf(opcode_s, "BCLR");
-								const int data = getword() & 0x002F;
+								const int data = getword(c) & 0x002F;
 								sprintf(source_s, "#%i", data);
 							} break;
 							case 18 : /* BSET_DREG */
@@ -532,7 +578,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 								break;
 							case 19 : { /* BSET_IMM */
 								sprintf(opcode_s, "BSET");
-								const int data = getword() & 0x002F;
+								const int data = getword(c) & 0x002F;
 								sprintf(source_s, "#%i", data);
 							} break;
 							case 20 : /* BTST_DREG */
@@ -541,12 +587,12 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 								break;
 							case 21 : {/* BTST_IMM */
 								sprintf(opcode_s,"BTST");
-								const int data = getword() & 0x002F;
+								const int data = getword(c) & 0x002F;
 								sprintf(source_s, "#%i", data);
 							} break;
 						}
 						char dest_s[50];
-						sprintmode(dmode, dreg, 0, dest_s);
+						sprintmode(c, dmode, dreg, 0, dest_s);
 						sprintf(operand_s, "%s,%s", source_s, dest_s);
 						decoded = true;
 					} break;
@@ -592,7 +638,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 								break;
 						}
 						char source_s[50];
-						sprintmode(smode, sreg, size, source_s);
+						sprintmode(c, smode, sreg, size, source_s);
 						sprintf(operand_s, "%s,D%i", source_s, dreg);
 						decoded = true;
 					} break;
@@ -605,7 +651,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 						if (size == 3) break;
 
 						sprintf(opcode_s, "CLR.%c", size_arr[size]);
-						sprintmode(dmode, dreg, size, operand_s);
+						sprintmode(c, dmode, dreg, size, operand_s);
 						decoded = true;
 					} break;
 					case 25 : {/* CMPA */
@@ -616,7 +662,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 
 						sprintf(opcode_s, "CMPA.%c", size_arr[size]);
 						char source_s[50];
-						sprintmode(smode, sreg, size, source_s);
+						sprintmode(c, smode, sreg, size, source_s);
 						sprintf(operand_s, "%s,A%i", source_s, areg);
 						decoded = true;
 					} break;
@@ -626,10 +672,10 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 
 						if (cc == 0) sprintf(opcode_s, "DBT");
 						if (cc == 1) sprintf(opcode_s, "DBF");
-						int offset = getword();
+						int offset = getword(c);
 						if (offset >= 32768) offset -= 65536;
 						const int dreg = word & 0x0007;
-						sprintf(operand_s, "D%i,$%08x", dreg, address - 2 + offset);
+						sprintf(operand_s, "D%i,$%08x", dreg, c->address + c->pcbias - 2 + offset);
 						decoded = true;
 					} break;
 					case 33 : { /* EXG */
@@ -676,7 +722,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 								break;
 						}
 
-						sprintmode(dmode, dreg, 0, operand_s);
+						sprintmode(c, dmode, dreg, 0, operand_s);
 						decoded = true;
 					} break;
 					case 37 : {/* LEA */
@@ -688,7 +734,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 						const int sreg = word & 0x0007;
 						sprintf(opcode_s, "LEA");
 						char source_s[50];
-						sprintmode(smode, sreg, 0, source_s);
+						sprintmode(c, smode, sreg, 0, source_s);
 
 						const int dreg = (word & 0x0E00) >> 9;
 						sprintf(operand_s, "%s,A%i", source_s, dreg);
@@ -696,7 +742,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 					} break;
 					case 38 : {/* LINK */
 						const int areg = word & 0x0007;
-						int offset = getword();
+						int offset = getword(c);
 						if (offset >= 32768) offset -= 65536;
 						sprintf(opcode_s, "LINK");
 						sprintf(operand_s, "A%i,#%+i", areg, offset);
@@ -740,8 +786,8 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 						sprintf(opcode_s,"MOVE.%c",size_arr[size]);
 
 						char source_s[50], dest_s[50];
-						sprintmode(smode, sreg, size, source_s);
-						sprintmode(dmode, dreg, size, dest_s);
+						sprintmode(c, smode, sreg, size, source_s);
+						sprintmode(c, dmode, dreg, size, dest_s);
 						sprintf(operand_s, "%s,%s ", source_s, dest_s);
 						decoded = true;
 					} break;
@@ -756,7 +802,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 
 						sprintf(opcode_s, "MOVE.W");
 						char source_s[50];
-						sprintmode(smode, sreg, size, source_s);
+						sprintmode(c, smode, sreg, size, source_s);
 						if (opnum == 44) {
 							sprintf(operand_s, "%s,CCR", source_s);
 						} else {
@@ -774,7 +820,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 
 						sprintf(opcode_s, "MOVE.W");
 						char dest_s[50];
-						sprintmode(dmode, dreg, size, dest_s);
+						sprintmode(c, dmode, dreg, size, dest_s);
 						sprintf(operand_s, "SR,%s", dest_s);
 						decoded = true;
 					} break;
@@ -805,7 +851,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 						sprintf(opcode_s, "MOVEA.%c", size_arr[size]);
 
 						char source_s[50];
-						sprintmode(smode, sreg, size, source_s);
+						sprintmode(c, smode, sreg, size, source_s);
 						sprintf(operand_s, "%s,A%i", source_s, dreg);
 						decoded = true;
 					} break;
@@ -821,7 +867,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 						if ((dir == 0) && (dmode == 3)) break;
 						if ((dir == 1) && (dmode == 4)) break;
 
-						const int data = getword();
+						const int data = getword(c);
 						if (dmode == 4) { /* dir == 0 if dmode == 4 !! */
 							/* reverse bits in data */
 							int temp = data;
@@ -897,7 +943,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 						}
 
 						sprintf(opcode_s, "MOVEM.%c", size_arr[size]);
-						sprintmode(dmode, dreg, size, dest_s);
+						sprintmode(c, dmode, dreg, size, dest_s);
 						if (dir == 0) {
 							/* the comma comes from the reglist */
 							sprintf(operand_s, "%s%s", source_s, dest_s);
@@ -915,7 +961,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 
 						if (size == 3) break;
 
-						const int data = getword();
+						const int data = getword(c);
 						sprintf(opcode_s, "MOVEP.%c", size_arr[size]);
 						if ((word & 0x0080) == 0) {
 							/* mem -> data reg */
@@ -954,7 +1000,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 							case 58 : sprintf(opcode_s, "NOT.%c", size_arr[size]);
 								break;
 						}
-						sprintmode(dmode, dreg, size, operand_s);
+						sprintmode(c, dmode, dreg, size, operand_s);
 						decoded = true;
 					} break;
 					case 57 :
@@ -997,7 +1043,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 
 						sprintf(opcode_s, "PEA");
 						const int sreg = word & 0x0007;
-						sprintmode(smode, sreg, 0, operand_s);
+						sprintmode(c, smode, sreg, 0, operand_s);
 						decoded = true;
 					} break;
 					case 75 : {/* Scc */
@@ -1010,7 +1056,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 
 						sprintf(opcode_s, "%s", scc_tab[cc]);
 						char dest_s[50];
-						sprintmode(dmode, dreg, 0, dest_s);
+						sprintmode(c, dmode, dreg, 0, dest_s);
 						sprintf(operand_s, "%s", dest_s);
 						decoded = true;
 					} break;
@@ -1027,7 +1073,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 						if (dmode >= 9) break;
 
 						sprintf(opcode_s, "TAS ");
-						sprintmode(dmode, dreg, 0, operand_s);
+						sprintmode(c, dmode, dreg, 0, operand_s);
 						decoded = true;
 					} break;
 					case 84 : { /* TRAP */
@@ -1046,7 +1092,7 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 						if (size == 3) break;
 
 						sprintf(opcode_s, "TST ");
-						sprintmode(dmode, dreg, size, operand_s);
+						sprintmode(c, dmode, dreg, size, operand_s);
 						decoded = true;
 					} break;
 					case 87 : {/* UNLK */
@@ -1063,16 +1109,32 @@ void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned lon
 			if (decoded) opnum = 88;
 		}
 
-		const int fetched = address - start_address;
+		if (!decoded) {
+			c->address = start_address + 2;
+			sprintf(opcode_s, "DC.W");
+			sprintf(operand_s, "$%04X", word);
+		}
+
+		const int fetched = c->address - start_address;
+		if ((uint64_t)fetched > remaining) return dasm_truncated(data, remaining, fetched, outbuf, insn);
 
                 memcpy(outbuf,opcode_s,strlen(opcode_s));
                 memcpy(outbuf+strlen(opcode_s)," ",1);
                 memcpy(outbuf+strlen(opcode_s)+1,operand_s,strlen(operand_s));
                 memcpy(outbuf+strlen(opcode_s)+1+strlen(operand_s),"\0",1);
-                *outlen = fetched;
+                if (insn) {
+                        uint64_t target;
+                        const int f = flow(data, offset, &target);
+                        dasm_insn_text(insn, outbuf, f, target);
+                        insn->length = fetched;
+                }
 
-                return;
+                return fetched;
 
 	}
+	return 2;
 }
 
+const struct be_decoder be_decoder_m68k = {
+	"m68k", NULL, decodeM68K, dasm_decode_batch, 10, 2
+};
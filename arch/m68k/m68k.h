@@ -1,3 +1,7 @@
 #include <stdint.h>
 
-void decodeM68K(unsigned long int start, char *outbuf, int *outlen, unsigned long int offset0);
+#include "../../dasm/decoder.h"
+
+int decodeM68K(const struct dasm_ctx *ctx, const uint8_t *data, uint64_t remaining, uint64_t offset, char *outbuf, struct dasm_insn *insn);
+
+extern const struct be_decoder be_decoder_m68k;
@@ -3,7 +3,7 @@
 
 #include <stdint.h>
 #include <stdio.h>
-#include "../../editor.h"
+#include "mips.h"
 
 // regs
 
@@ -43,103 +43,94 @@ char * rsp_vec[] = {
    "vand", "vnand", "vor", "vnor", "vxor", "vnxor", 0, 0,
    "vcrp", "vrcpl", "vrcph", "vmov", "vrsq", "vrsql", "vrsqh", "vnop" };
 
-char str_opcode[256], str_bo[256], str_beqo[256], str_lost[256], str_vec_elem[256], str_vec[256], str_vecop[256], str_cop0[256];
-char str_cop2[256], str_cop[256], str_mc[256], str_reg[256], unknown[256];
+// Helpers format into the buffer they are given and return it.
 
-char *decodeVectorElement(uint8_t v, uint8_t e)
+
+char *decodeVectorElement(char *out, uint8_t v, uint8_t e)
 {
-    if ((e & 0x8) == 8) sprintf(str_vec_elem,"%i[%i]", v, (e & 0x7));
-    else if ((e & 0xC) == 4) sprintf(str_vec_elem,"%i[%ih]", v, (e & 0x3));
-    else if ((e & 0xE) == 2) sprintf(str_vec_elem,"%i[%iq]", v, (e & 0x1));
-    else sprintf(str_vec_elem,"%i", v);
-    return str_vec_elem;
+    if ((e & 0x8) == 8) sprintf(out,"%i[%i]", v, (e & 0x7));
+    else if ((e & 0xC) == 4) sprintf(out,"%i[%ih]", v, (e & 0x3));
+    else if ((e & 0xE) == 2) sprintf(out,"%i[%iq]", v, (e & 0x1));
+    else sprintf(out,"%i", v);
+    return out;
 }
 
-char *decodeVectorElementScalar(uint8_t opcode, uint32_t operation)
+char *decodeVectorElementScalar(char *out, uint8_t opcode, uint32_t operation)
 {
     uint8_t e  = (uint8_t)((operation >> 21) & 0xF);
     uint8_t vt = (uint8_t)((operation >> 16) & 0x1F);
     uint8_t de = (uint8_t)((operation >> 11) & 0x1F);
     uint8_t vd = (uint8_t)((operation >> 6) & 0x1F);
-    sprintf(str_vec,"%s f%s, f%s", rsp_vec[opcode], decodeVectorElement(vd, de), decodeVectorElement(vt, e));
-    return str_vec;
+    char d[16], t[16];
+    sprintf(out,"%s f%s, f%s", rsp_vec[opcode], decodeVectorElement(d, vd, de), decodeVectorElement(t, vt, e));
+    return out;
 }
 
-char *decodeVector(uint32_t operation)
+char *decodeVector(char *out, uint32_t operation)
 {
     uint8_t opcode = (uint8_t)(operation & 0x3F);
-    if (opcode == 0x37) { sprintf(str_vecop, "%s", "nop"); return str_vecop; }
-    else if (opcode < 0x37) {
-        sprintf(str_vecop, "%s", decodeVectorElementScalar(opcode, operation));
-        return str_vecop;
-    }
-
-    uint8_t e  = (uint8_t)((operation >> 21) & 0xF);
-    uint8_t vt = (uint8_t)((operation >> 16) & 0x1F);
-    uint8_t vs = (uint8_t)((operation >> 11) & 0x1F);
-    uint8_t vd = (uint8_t)((operation >> 6) & 0x1F);
-
-    sprintf(str_vecop, "%s f%i, f%i, f%s", (rsp_vec[opcode] == 0 ? unknown : rsp_vec[opcode]),
-       vd, vs, decodeVectorElement(vt, e));
-    return str_vecop;
+    if (opcode == 0x37) sprintf(out, "%s", "nop");
+    else if (opcode < 0x37) decodeVectorElementScalar(out, opcode, operation);
+    else sprintf(out, ".word 0x%08X", operation); // past the end of rsp_vec
+    return out;
 }
 
-char *decodeMoveControlToFromCoprocessor(char *opcode, uint32_t operation)
+char *decodeMoveControlToFromCoprocessor(char *out, char *opcode, uint32_t operation)
 {
     uint8_t rt = (uint8_t)((operation >> 16) & 0x1F);
     uint8_t rd = (uint8_t)((operation >> 11) & 0x1F);
-    sprintf(str_mc, "%s %s, f%i", opcode, gpr[rt], rd);
-    return str_mc;
+    sprintf(out, "%s %s, f%i", opcode, gpr[rt], rd);
+    return out;
 }
 
-char * decodeMoveToFromCoprocessor(char *opcode, uint32_t operation)
+char * decodeMoveToFromCoprocessor(char *out, char *opcode, uint32_t operation)
 {
     uint8_t rt = (uint8_t)((operation >> 16) & 0x1F);
     uint8_t rd = (uint8_t)((operation >> 11) & 0x1F);
     uint8_t e  = (uint8_t)((operation >> 7) & 0xF);
-    sprintf(str_mc, "%s %s, f%i[%i]", opcode, gpr[rt], rd, e);
-    return str_mc;
+    sprintf(out, "%s %s, f%i[%i]", opcode, gpr[rt], rd, e);
+    return out;
 }
 
-char *decodeCOP0(uint32_t operation) {
+char *decodeCOP0(char *out, uint32_t operation) {
      uint8_t mt = (uint8_t)((operation >> 21) & 0x1F);
      uint8_t rt = (uint8_t)((operation >> 16) & 0x1F);
      uint8_t rd = (uint8_t)((operation >> 11) & 0x1F);
      uint8_t sel = (uint8_t)(operation & 0x3);
      uint8_t sc = (uint8_t)((operation >> 5) & 1);
-     sprintf(str_cop0, ".word 0x%08X", operation);
+     sprintf(out, ".word 0x%08X", operation);
      if ((operation >> 25) & 1) switch (operation & 0x3F) {
-         case 0x01: sprintf(str_cop0, "tlbr"); break;
-         case 0x02: sprintf(str_cop0, "tlbwi"); break;
-         case 0x03: sprintf(str_cop0, "tlbinv"); break;
-         case 0x04: sprintf(str_cop0, "tlbinvf"); break;
-         case 0x06: sprintf(str_cop0, "tlbwr"); break;
-         case 0x08: sprintf(str_cop0, "tlbp"); break;
-         case 0x18: sprintf(str_cop0, ((operation >> 6) & 1) ? "eretnc" : "eret"); break;
-         case 0x1F: sprintf(str_cop0, "deret"); break;
-         case 0x20: sprintf(str_cop0, "wait"); break;
+         case 0x01: sprintf(out, "tlbr"); break;
+         case 0x02: sprintf(out, "tlbwi"); break;
+         case 0x03: sprintf(out, "tlbinv"); break;
+         case 0x04: sprintf(out, "tlbinvf"); break;
+         case 0x06: sprintf(out, "tlbwr"); break;
+         case 0x08: sprintf(out, "tlbp"); break;
+         case 0x18: sprintf(out, ((operation >> 6) & 1) ? "eretnc" : "eret"); break;
+         case 0x1F: sprintf(out, "deret"); break;
+         case 0x20: sprintf(out, "wait"); break;
          default: break;
      } else switch (mt) {
-         case 0x00: sprintf(str_cop0, "mfc0 %s, %s, %i", gpr[rt], cp0[rd], sel); break;
-         case 0x01: sprintf(str_cop0, "dmfc0 %s, %s", gpr[rt], cp0[rd]); break;
-         case 0x02: sprintf(str_cop0, "mfhc0 %s, %s, %i", gpr[rt], cp0[rd], sel); break;
-         case 0x04: sprintf(str_cop0, "mtc0 %s, %s", gpr[rt], cp0[rd]); break;
-         case 0x05: sprintf(str_cop0, "dmtc0 %s, %s", gpr[rt], cp0[rd]); break;
-         case 0x06: sprintf(str_cop0, "mthc0 %s, %s, %i", gpr[rt], cp0[rd], sel); break;
-         case 0x0A: sprintf(str_cop0, "rdpgpr %s, %s", gpr[rd], gpr[rt]); break;
-         case 0x0B: sprintf(str_cop0, sc ? "ei %s" : "di %s", gpr[rt]); break;
-         case 0x0E: sprintf(str_cop0, "wrpgpr %s, %s", gpr[rd], gpr[rt]); break;
+         case 0x00: sprintf(out, "mfc0 %s, %s, %i", gpr[rt], cp0[rd], sel); break;
+         case 0x01: sprintf(out, "dmfc0 %s, %s", gpr[rt], cp0[rd]); break;
+         case 0x02: sprintf(out, "mfhc0 %s, %s, %i", gpr[rt], cp0[rd], sel); break;
+         case 0x04: sprintf(out, "mtc0 %s, %s", gpr[rt], cp0[rd]); break;
+         case 0x05: sprintf(out, "dmtc0 %s, %s", gpr[rt], cp0[rd]); break;
+         case 0x06: sprintf(out, "mthc0 %s, %s, %i", gpr[rt], cp0[rd], sel); break;
+         case 0x0A: sprintf(out, "rdpgpr %s, %s", gpr[rd], gpr[rt]); break;
+         case 0x0B: sprintf(out, sc ? "ei %s" : "di %s", gpr[rt]); break;
+         case 0x0E: sprintf(out, "wrpgpr %s, %s", gpr[rd], gpr[rt]); break;
          default: break;
      }
-     return str_cop0;
+     return out;
 }
 
-char *decodeCOP1X(uint32_t operation) {
-     sprintf(str_cop, ".word 0x%08X", operation);
-     return str_cop;
+char *decodeCOP1X(char *out, uint32_t operation) {
+     sprintf(out, ".word 0x%08X", operation);
+     return out;
 }
 
-char *decodeCOP1(uint32_t operation) {
+char *decodeCOP1(char *out, uint32_t operation) {
      uint8_t fmt  = (uint8_t)((operation >> 21) & 0x1F);
      uint8_t function =     (uint8_t)(operation & 0x3F);
      uint8_t rt   = (uint8_t)((operation >> 16) & 0x1F);
@@ -150,18 +141,18 @@ char *decodeCOP1(uint32_t operation) {
      uint16_t offset = (uint16_t)((operation & 0xFFFF));
      char *suffix[4] = { "s","d", "w", "l", 0 };
      switch (fmt) {
-         case 0x00: sprintf(str_cop0,  "mfc1 %s, f%i", gpr[rt], fs); break;
-         case 0x01: sprintf(str_cop0, "dmfc1 %s, f%i", gpr[rt], fs); break;
-         case 0x02: sprintf(str_cop0,  "cfc1 %s, f%i", gpr[rt], fs); break;
-         case 0x04: sprintf(str_cop0,  "mtc1 %s, f%i", gpr[rt], fs); break;
-         case 0x05: sprintf(str_cop0, "dmtc1 %s, f%i", gpr[rt], fs); break;
-         case 0x06: sprintf(str_cop0,  "ctc1 %i, f%i", gpr[rt], fs); break;
+         case 0x00: sprintf(out,  "mfc1 %s, f%i", gpr[rt], fs); break;
+         case 0x01: sprintf(out, "dmfc1 %s, f%i", gpr[rt], fs); break;
+         case 0x02: sprintf(out,  "cfc1 %s, f%i", gpr[rt], fs); break;
+         case 0x04: sprintf(out,  "mtc1 %s, f%i", gpr[rt], fs); break;
+         case 0x05: sprintf(out, "dmtc1 %s, f%i", gpr[rt], fs); break;
+         case 0x06: sprintf(out,  "ctc1 %s, f%i", gpr[rt], fs); break;
          case 0x08: // BC
                     switch (ndtt) {
-                        case 0: sprintf(str_cop0,  "bc1f %s, %s", cc, offset); break;
-                        case 1: sprintf(str_cop0,  "bc1t %s, %s", cc, offset); break;
-                        case 2: sprintf(str_cop0, "bc1fl %s, %s", cc, offset); break;
-                        case 3: sprintf(str_cop0, "bc1tl %s, %s", cc, offset); break;
+                        case 0: sprintf(out,  "bc1f %i, 0x%x", cc, offset); break;
+                        case 1: sprintf(out,  "bc1t %i, 0x%x", cc, offset); break;
+                        case 2: sprintf(out, "bc1fl %i, 0x%x", cc, offset); break;
+                        case 3: sprintf(out, "bc1tl %i, 0x%x", cc, offset); break;
                         default: break;
                     }
                     break;
@@ -170,169 +161,163 @@ char *decodeCOP1(uint32_t operation) {
          case 0x12: case 0x13: case 0x14: // W
          case 0x15: case 0x16: case 0x17: // L
                     switch (function) { // S, D, W
-                        case 0x00: sprintf(str_cop0,    "add.%s f%i, f%i, f%i", suffix[fmt&3], fd, fs, rt); break;
-                        case 0x01: sprintf(str_cop0,    "sub.%s f%i, f%i, f%i", suffix[fmt&3], fd, fs, rt); break;
-                        case 0x02: sprintf(str_cop0,    "mul.%s f%i, f%i, f%i", suffix[fmt&3], fd, fs, rt); break;
-                        case 0x03: sprintf(str_cop0,    "div.%s f%i, f%i, f%i", suffix[fmt&3], fd, fs, rt); break;
-                        case 0x04: sprintf(str_cop0,   "sqrt.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
-                        case 0x05: sprintf(str_cop0,    "abs.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
-                        case 0x06: sprintf(str_cop0,    "mov.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
-                        case 0x07: sprintf(str_cop0,    "neg.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
-                        case 0x08: sprintf(str_cop0,"round.l.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
-                        case 0x09: sprintf(str_cop0,"trunc.l.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
-                        case 0x0A: sprintf(str_cop0, "ceil.l.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
-                        case 0x0B: sprintf(str_cop0,"floor.l.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
-                        case 0x0C: sprintf(str_cop0,"round.w.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
-                        case 0x0D: sprintf(str_cop0,"trunc.w.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
-                        case 0x0E: sprintf(str_cop0, "ceil.w.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
-                        case 0x0F: sprintf(str_cop0,"floor.w.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
-                        case 0x11: sprintf(str_cop0,   "movt.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
-                        case 0x12: sprintf(str_cop0,   "movz.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
-                        case 0x13: sprintf(str_cop0,   "movn.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
-                        case 0x15: sprintf(str_cop0,  "recip.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
-                        case 0x16: sprintf(str_cop0,  "rsqrt.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
-                        case 0x20: sprintf(str_cop0,  "cvt.s.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
-                        case 0x21: sprintf(str_cop0,  "cvt.d.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
-                        case 0x24: sprintf(str_cop0,  "cvt.w.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
-                        case 0x25: sprintf(str_cop0,  "cvt.l.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
-                        case 0x30: sprintf(str_cop0,    "c.f.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
-                        case 0x31: sprintf(str_cop0,   "c.un.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
-                        case 0x32: sprintf(str_cop0,   "c.eq.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
-                        case 0x33: sprintf(str_cop0,  "c.ueq.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
-                        case 0x34: sprintf(str_cop0,  "c.olt.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
-                        case 0x35: sprintf(str_cop0,  "c.ult.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
-                        case 0x36: sprintf(str_cop0,  "c.ole.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
-                        case 0x37: sprintf(str_cop0,  "c.ule.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
-                        case 0x38: sprintf(str_cop0,   "c.sf.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
-                        case 0x39: sprintf(str_cop0, "c.ngle.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
-                        case 0x3A: sprintf(str_cop0,  "c.seq.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
-                        case 0x3B: sprintf(str_cop0,  "c.ngl.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
-                        case 0x3C: sprintf(str_cop0,   "c.lt.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
-                        case 0x3D: sprintf(str_cop0,  "c.nge.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
-                        case 0x3E: sprintf(str_cop0,   "c.le.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
-                        case 0x3F: sprintf(str_cop0,  "c.ngt.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
+                        case 0x00: sprintf(out,    "add.%s f%i, f%i, f%i", suffix[fmt&3], fd, fs, rt); break;
+                        case 0x01: sprintf(out,    "sub.%s f%i, f%i, f%i", suffix[fmt&3], fd, fs, rt); break;
+                        case 0x02: sprintf(out,    "mul.%s f%i, f%i, f%i", suffix[fmt&3], fd, fs, rt); break;
+                        case 0x03: sprintf(out,    "div.%s f%i, f%i, f%i", suffix[fmt&3], fd, fs, rt); break;
+                        case 0x04: sprintf(out,   "sqrt.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
+                        case 0x05: sprintf(out,    "abs.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
+                        case 0x06: sprintf(out,    "mov.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
+                        case 0x07: sprintf(out,    "neg.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
+                        case 0x08: sprintf(out,"round.l.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
+                        case 0x09: sprintf(out,"trunc.l.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
+                        case 0x0A: sprintf(out, "ceil.l.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
+                        case 0x0B: sprintf(out,"floor.l.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
+                        case 0x0C: sprintf(out,"round.w.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
+                        case 0x0D: sprintf(out,"trunc.w.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
+                        case 0x0E: sprintf(out, "ceil.w.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
+                        case 0x0F: sprintf(out,"floor.w.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
+                        case 0x11: sprintf(out,   "movt.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
+                        case 0x12: sprintf(out,   "movz.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
+                        case 0x13: sprintf(out,   "movn.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
+                        case 0x15: sprintf(out,  "recip.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
+                        case 0x16: sprintf(out,  "rsqrt.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
+                        case 0x20: sprintf(out,  "cvt.s.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
+                        case 0x21: sprintf(out,  "cvt.d.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
+                        case 0x24: sprintf(out,  "cvt.w.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
+                        case 0x25: sprintf(out,  "cvt.l.%s f%i, f%i", suffix[fmt&3], fd, fs); break;
+                        case 0x30: sprintf(out,    "c.f.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
+                        case 0x31: sprintf(out,   "c.un.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
+                        case 0x32: sprintf(out,   "c.eq.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
+                        case 0x33: sprintf(out,  "c.ueq.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
+                        case 0x34: sprintf(out,  "c.olt.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
+                        case 0x35: sprintf(out,  "c.ult.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
+                        case 0x36: sprintf(out,  "c.ole.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
+                        case 0x37: sprintf(out,  "c.ule.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
+                        case 0x38: sprintf(out,   "c.sf.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
+                        case 0x39: sprintf(out, "c.ngle.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
+                        case 0x3A: sprintf(out,  "c.seq.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
+                        case 0x3B: sprintf(out,  "c.ngl.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
+                        case 0x3C: sprintf(out,   "c.lt.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
+                        case 0x3D: sprintf(out,  "c.nge.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
+                        case 0x3E: sprintf(out,   "c.le.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
+                        case 0x3F: sprintf(out,  "c.ngt.%s f%i, f%i", suffix[fmt&3], fs, rt); break;
                         default: break;
                     }
                     break;
            default: break;
      }
 
-     return str_cop0;
+     return out;
 }
 
-char *decodeCOP2(uint32_t operation) {
-    if ((operation & 0x7FF) != 0) return decodeVector(operation);
+char *decodeCOP2(char *out, uint32_t operation) {
+    if ((operation & 0x7FF) != 0) return decodeVector(out, operation);
     uint8_t subop = (uint8_t)((operation >> 21) & 0x1F);
     switch (subop) {
-        case 0x00: return decodeMoveToFromCoprocessor("mfc2", operation);
-        case 0x04: return decodeMoveToFromCoprocessor("mtc2", operation);
-        case 0x02: return decodeMoveControlToFromCoprocessor("cfc2", operation);
-        case 0x06: return decodeMoveControlToFromCoprocessor("ctc2", operation);
-        default:   sprintf(str_cop0, ".word 0x%08X", operation); 
-        sprintf(str_cop2, ".word 0x%08X", operation);
-                   return str_cop2;
+        case 0x00: return decodeMoveToFromCoprocessor(out, "mfc2", operation);
+        case 0x04: return decodeMoveToFromCoprocessor(out, "mtc2", operation);
+        case 0x02: return decodeMoveControlToFromCoprocessor(out, "cfc2", operation);
+        case 0x06: return decodeMoveControlToFromCoprocessor(out, "ctc2", operation);
+        default:   sprintf(out, ".word 0x%08X", operation); 
+        sprintf(out, ".word 0x%08X", operation);
+                   return out;
     }
 }
 
 
-char *decodeTwoRegistersWithImmediate(char *opcode, uint32_t operation)
+char *decodeTwoRegistersWithImmediate(char *out, char *opcode, uint32_t operation)
 {
      uint8_t dst = (uint8_t)((operation >> 16) & 0x1F);
      uint8_t src = (uint8_t)((operation >> 21) & 0x1F);
      uint16_t imm = (uint16_t)(operation & 0xFFFF);
-     if (imm < 0) sprintf(str_lost,"%s %s, %s, 0x%x", opcode, gpr[dst], gpr[src], imm);
-             else sprintf(str_lost,"%s %s, %s, 0x%x", opcode, gpr[dst], gpr[src], imm);
-     return str_lost;
+     if (imm < 0) sprintf(out,"%s %s, %s, 0x%x", opcode, gpr[dst], gpr[src], imm);
+             else sprintf(out,"%s %s, %s, 0x%x", opcode, gpr[dst], gpr[src], imm);
+     return out;
 }
 
-char *decodeOneRegisterWithImmediate(char *opcode, uint32_t operation)
+char *decodeOneRegisterWithImmediate(char *out, char *opcode, uint32_t operation)
 {
      uint8_t dst = (uint8_t)((operation >> 16) & 0x1F);
-     sprintf(str_reg, "%s %s, 0x%x", opcode, gpr[dst], operation & 0xFFFF);
-     return str_reg;
+     sprintf(out, "%s %s, 0x%x", opcode, gpr[dst], operation & 0xFFFF);
+     return out;
 }
 
-char *decodeThreeRegister(char* opcode, uint32_t operation, int swapRT_RS)
+char *decodeThreeRegister(char *out, char* opcode, uint32_t operation, int swapRT_RS)
 {
      uint8_t dest = (uint8_t)((operation >> 11) & 0x1F);
      uint8_t src1 = (uint8_t)((operation >> 21) & 0x1F);
      uint8_t src2 = (uint8_t)((operation >> 16) & 0x1F);
-     if(!swapRT_RS) sprintf(str_reg,"%s %s, %s, %s", opcode, gpr[dest], gpr[src1], gpr[src2]);
-     else sprintf(str_reg,"%s %s, %s, %s", opcode, gpr[dest], gpr[src2], gpr[src1]);
-     return str_reg;
+     if(!swapRT_RS) sprintf(out,"%s %s, %s, %s", opcode, gpr[dest], gpr[src1], gpr[src2]);
+     else sprintf(out,"%s %s, %s, %s", opcode, gpr[dest], gpr[src2], gpr[src1]);
+     return out;
 }
-char * decodeBranch(char *opcode, uint32_t operation, unsigned long int address)
+char * decodeBranch(char *out, char *opcode, uint32_t operation, unsigned long int address)
 {
      uint8_t src = (uint8_t)((operation >> 21) & 0x1F);
-     uint16_t imm = (uint16_t)((operation & 0xFFFF) << 2);
+     int32_t imm = (int16_t)(operation & 0xFFFF) * 4;
      uint32_t current_offset = (uint32_t)((address + 4) + imm);
-     sprintf(str_bo, "%s %s, 0x%8x", opcode, gpr[src], current_offset);
-     return str_bo;
+     sprintf(out, "%s %s, 0x%8x", opcode, gpr[src], current_offset);
+     return out;
 }
 
-char * decodeBranchEquals(char * opcode, uint32_t operation, unsigned long int address)
+char * decodeBranchEquals(char *out, char * opcode, uint32_t operation, unsigned long int address)
 {
      uint8_t src1 = (uint8_t)((operation >> 21) & 0x1F);
      uint8_t src2 = (uint8_t)((operation >> 16) & 0x1F);
-     uint16_t imm = (uint16_t)((operation & 0xFFFF) << 2);
+     int32_t imm = (int16_t)(operation & 0xFFFF) * 4;
      uint32_t current_offset = (uint32_t)((address + 4) + imm);
-     sprintf(str_beqo, "%s %s, %s, 0x%08x", opcode, gpr[src1], gpr[src2], current_offset);
-     return str_beqo;
+     sprintf(out, "%s %s, %s, 0x%08x", opcode, gpr[src1], gpr[src2], current_offset);
+     return out;
 }
 
-char *decodeSpecialShift(char *opcode, uint32_t operation)
+char *decodeSpecialShift(char *out, char *opcode, uint32_t operation)
 {
      uint8_t dest = (uint8_t)((operation >> 11) & 0x1F);
      uint8_t src  = (uint8_t)((operation >> 16) & 0x1F);
      int imm = (int)((operation >> 6) & 0x1F);
-     sprintf(str_lost, "%s %s, %s, %i", opcode, gpr[dest], gpr[src], imm);
-     return str_lost;
+     sprintf(out, "%s %s, %s, %i", opcode, gpr[dest], gpr[src], imm);
+     return out;
 }
 
-uint32_t le_to_be(uint32_t num) {
-    uint8_t b[4] = {0}; *(uint32_t*)b = num; uint8_t tmp = 0; tmp = b[0];
-    b[0] = b[3]; b[3] = tmp; tmp = b[1]; b[1] = b[2]; b[2] = tmp; return *(uint32_t*)b;
-}
-
-char *decodeLoadStore(char *opcode, uint32_t operation)
+char *decodeLoadStore(char *out, char *opcode, uint32_t operation)
 {
      uint8_t rt = (uint8_t)((operation >> 16) & 0x1F);
      uint8_t base = (uint8_t)((operation >> 21) & 0x1F);
      uint16_t offset = (uint16_t)(operation & 0xFFFF);
-     if (offset < 0) sprintf(str_lost,"%s %s, -0x%08X(%s)", opcode, gpr[rt], offset, gpr[base]);
-             else sprintf(str_lost,"%s %s, 0x%08X(%s)", opcode, gpr[rt], offset, gpr[base]);
-     return str_lost;
+     if (offset < 0) sprintf(out,"%s %s, -0x%08X(%s)", opcode, gpr[rt], offset, gpr[base]);
+             else sprintf(out,"%s %s, 0x%08X(%s)", opcode, gpr[rt], offset, gpr[base]);
+     return out;
 }
 
-char * decodeMIPS(unsigned long int address, char *outbuf, int*lendis, unsigned long int offset) {
-    uint32_t operation = le_to_be((uint32_t)*((unsigned long int *)address)); *lendis = 4;
-    if (operation == 0x00000000) { sprintf(outbuf, "%s", "nop"); return outbuf; }
+static void format(char *outbuf, uint32_t operation, unsigned long int offset) {
+    if (operation == 0x00000000) { sprintf(outbuf, "%s", "nop"); return; }
     uint8_t reg = (uint8_t)((operation >> 21) & 0x1F);
     uint8_t opcode = (uint8_t)((operation >> 26) & 0x3F);
     sprintf(outbuf,".word 0x%08X", operation);
     if (opcode == 0x00) { // SPECIAL
         uint8_t function = (uint8_t)(operation & 0x3F);
-        if (function < 0x04 && specials[function]) sprintf(outbuf, "%s", decodeSpecialShift(specials[function], operation));
-        else if (function < 0x08 && specials[function]) sprintf(outbuf, "%s", decodeThreeRegister(specials[function], operation, 1));
+        if (function < 0x04 && specials[function]) decodeSpecialShift(outbuf, specials[function], operation);
+        else if (function < 0x08 && specials[function]) decodeThreeRegister(outbuf, specials[function], operation, 1);
         else if (function == 0x08 && specials[function]) sprintf(outbuf, "%s %s", specials[function], gpr[reg]);
         else if (function == 0x09) {
              uint8_t return_reg = (uint8_t)((operation >> 11) & 0x1F);
              if (return_reg == 0xF && specials[function]) sprintf(outbuf, "%s %s", specials[function], gpr[reg]);
              else sprintf(outbuf, "%s %s, %s", specials[function], gpr[return_reg], gpr[reg]);
         } else if (function < 0x20 && specials[function]) sprintf(outbuf, "%s %i", specials[function], ((operation >> 6) & 0xFFFFF));
-        else if (function < 0x40 && specials[function]) sprintf(outbuf, "%s", decodeThreeRegister(specials[function], operation, 0));
+        else if (function < 0x40 && specials[function]) decodeThreeRegister(outbuf, specials[function], operation, 0);
     } else if (opcode == 0x01) { // REGIMM
         uint8_t rt = (uint8_t)((operation >> 16) & 0x1F);
-        if (rt < 0x14 && regimm[rt]) sprintf(outbuf, "%s", decodeBranch(regimm[rt], operation, offset));
+        if (rt < 0x14 && regimm[rt]) decodeBranch(outbuf, regimm[rt], operation, offset);
     } else if (opcode  < 0x04 && rsp[opcode]) sprintf(outbuf, "%s 0x0%x", rsp[opcode], ((operation & 0x03FFFFFF) << 2));
-    else if (opcode  < 0x06 && rsp[opcode]) sprintf(outbuf, "%s", decodeBranchEquals(rsp[opcode], operation, offset));
-    else if (opcode  < 0x08 && rsp[opcode]) sprintf(outbuf, "%s", decodeBranch(rsp[opcode], operation, offset));
-    else if (opcode  < 0x0F && rsp[opcode]) sprintf(outbuf, "%s", decodeTwoRegistersWithImmediate(rsp[opcode], operation));
-    else if (opcode  < 0x10 && rsp[opcode]) sprintf(outbuf, "%s", decodeOneRegisterWithImmediate(rsp[opcode], operation));
-    else if (opcode == 0x10) sprintf(outbuf, "%s", decodeCOP0(operation));
-    else if (opcode == 0x11) sprintf(outbuf, "%s", decodeCOP1(operation));
-    else if (opcode == 0x12) sprintf(outbuf, "%s", decodeCOP2(operation));
-    else if (opcode == 0x13) sprintf(outbuf, "%s", decodeCOP1X(operation));
+    else if (opcode  < 0x06 && rsp[opcode]) decodeBranchEquals(outbuf, rsp[opcode], operation, offset);
+    else if (opcode  < 0x08 && rsp[opcode]) decodeBranch(outbuf, rsp[opcode], operation, offset);
+    else if (opcode  < 0x0F && rsp[opcode]) decodeTwoRegistersWithImmediate(outbuf, rsp[opcode], operation);
+    else if (opcode  < 0x10 && rsp[opcode]) decodeOneRegisterWithImmediate(outbuf, rsp[opcode], operation);
+    else if (opcode == 0x10) decodeCOP0(outbuf, operation);
+    else if (opcode == 0x11) decodeCOP1(outbuf, operation);
+    else if (opcode == 0x12) decodeCOP2(outbuf, operation);
+    else if (opcode == 0x13) decodeCOP1X(outbuf, operation);
     else if (opcode == 0x1D) { sprintf(outbuf, "jalx 0x%08X", operation & 0x1FFFFFF); }
     else if (opcode == 0x1C) { // SPECIAL2
     }
@@ -340,6 +325,51 @@ char * decodeMIPS(unsigned long int address, char *outbuf, int*lendis, unsigned
     }
     else if ((opcode == 0x1A) || (opcode == 0x1B) || ((opcode > 0x1F) && (opcode < 0x2F)) ||
              (opcode != 0x3B && ((opcode > 0x2F) || (opcode < 0x40))) && rsp[opcode])
-             sprintf(outbuf, "%s", decodeLoadStore(rsp[opcode],operation));
-    return outbuf;
-}
\ No newline at end of file
+             decodeLoadStore(outbuf, rsp[opcode],operation);
+}
+
+static int flow(uint32_t operation, unsigned long int offset, uint64_t *target)
+{
+    uint8_t opcode = (uint8_t)((operation >> 26) & 0x3F);
+    uint8_t rs = (uint8_t)((operation >> 21) & 0x1F), rt = (uint8_t)((operation >> 16) & 0x1F);
+    uint64_t branch = offset + 4 + (int64_t)(int16_t)(operation & 0xFFFF) * 4;
+    uint64_t region = ((offset + 4) & ~0x0FFFFFFFull) | ((operation & 0x03FFFFFF) << 2);
+    *target = DASM_NO_TARGET;
+    switch (opcode) {
+        case 0x00:
+            if ((operation & 0x3F) == 0x08) return rs == 31 ? DASM_FLOW_RET : DASM_FLOW_JUMP;
+            if ((operation & 0x3F) == 0x09) return DASM_FLOW_CALL;
+            return DASM_FLOW_NEXT;
+        case 0x01:
+            if ((rt & 0x1C) == 0x00) { *target = branch; return DASM_FLOW_BRANCH; }
+            if ((rt & 0x1C) == 0x10) { *target = branch; return DASM_FLOW_CALL; }
+            return DASM_FLOW_NEXT;
+        case 0x02: *target = region; return DASM_FLOW_JUMP;
+        case 0x03: case 0x1D: *target = region; return DASM_FLOW_CALL;
+        case 0x04:
+            *target = branch;
+            return rs == 0 && rt == 0 ? DASM_FLOW_JUMP : DASM_FLOW_BRANCH;
+        case 0x05: case 0x06: case 0x07:
+        case 0x14: case 0x15: case 0x16: case 0x17:
+            *target = branch; return DASM_FLOW_BRANCH;
+        case 0x10: return operation == 0x42000018 ? DASM_FLOW_RET : DASM_FLOW_NEXT;
+        default: return DASM_FLOW_NEXT;
+    }
+}
+
+int decodeMIPS(const struct dasm_ctx *ctx, const uint8_t *data, uint64_t remaining, uint64_t offset, char *text, struct dasm_insn *insn) {
+    if (remaining < 4) return dasm_truncated(data, remaining, 4, text, insn);
+    uint32_t operation = (uint32_t)data[0] << 24 | data[1] << 16 | data[2] << 8 | data[3];
+    format(text, operation, offset);
+    if (insn) {
+        uint64_t target;
+        int f = flow(operation, offset, &target);
+        dasm_insn_text(insn, text, f, target);
+        insn->length = 4;
+    }
+    return 4;
+}
+
+const struct be_decoder be_decoder_mips = {
+    "mips", NULL, decodeMIPS, dasm_decode_batch, 4, 4
+};
\ No newline at end of file
@@ -6,27 +6,32 @@
 #include <string.h>
 #include <stdio.h>
 
-#include "../../editor.h"
+#include "nv.h"
 
-uint64_t NVword(unsigned long int address) {
-    uint64_t operation = (uint64_t)*((unsigned long int *)address);
+uint64_t NVword(const uint8_t *data) {
+    uint64_t operation = 0;
+    for (int i = 7; i >= 0; i--) operation = operation << 8 | data[i];
     return operation;
 }
 
-char nvout[1000];
-
-char *decodeNV(unsigned long int address, char *outbuf, int *lendis, unsigned long int offset0)
+int decodeNV(const struct dasm_ctx *ctx, const uint8_t *data, uint64_t remaining, uint64_t offset, char *outbuf, struct dasm_insn *insn)
 {
-    struct editor *e = editor();
-    unsigned long int start = address, i;
-    unsigned long int finish = address + 8;
-    uint64_t operation = NVword(start);
+    char nvout[1000];
+    unsigned long int i;
+    if (remaining < 8) return dasm_truncated(data, remaining, 8, outbuf, insn);
     for (i = 0; i < 1000; i++) nvout[i] = 0;
 
     sprintf(nvout, "%s ", "nop");
 
     memcpy(outbuf,nvout,strlen(nvout));
     outbuf[strlen(nvout)] = '\0';
-    *lendis = finish - start;
-    return outbuf;
+    if (insn) {
+        dasm_insn_text(insn, outbuf, DASM_FLOW_NEXT, DASM_NO_TARGET);
+        insn->length = 8;
+    }
+    return 8;
 }
+
+const struct be_decoder be_decoder_nv = {
+    "nv", NULL, decodeNV, dasm_decode_batch, 8, 8
+};
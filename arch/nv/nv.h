@@ -1,3 +1,7 @@
 #include <stdint.h>
 
-char * decodeNV(unsigned long int address, char *outbuf, int *lendis, unsigned long int offset);
+#include "../../dasm/decoder.h"
+
+int decodeNV(const struct dasm_ctx *ctx, const uint8_t *data, uint64_t remaining, uint64_t offset, char *outbuf, struct dasm_insn *insn);
+
+extern const struct be_decoder be_decoder_nv;
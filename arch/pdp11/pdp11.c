@@ -6,7 +6,7 @@
 #include <string.h>
 #include <stdio.h>
 
-#include "../../editor.h"
+#include "pdp11.h"
 
 struct Plain { const char* name; unsigned code; };
 struct Immediate { const char* name; unsigned code; short bits; int mask; int arg; };
@@ -125,17 +125,43 @@ char* two[] = {
   0, "movb", "cmpb", "bitb", "bicb", "bisb", "sub", 0, 0 };
 
 char* reg_addr[] = { "%s", "(%s)", "(%s)+", "@(%s)+", "-(%s)", "@-(%s)", "0x%X(%s)", "@0x%X(%s)", 0 };
-char pdpout[1000];
 
 uint16_t pdp11word(unsigned long int address) {
-    uint16_t operation = (uint16_t)*((unsigned long int *)address);
-    operation = (operation << 8) | (operation >> 8);
-    return operation;
+    const uint8_t *p = (const uint8_t *)address;
+    return (uint16_t)(p[0] << 8 | p[1]);
 }
 
-char * decodePDP11(unsigned long int address, char *outbuf, int *lendis, unsigned long int offset0)
+// Control flow in the same word order as pdp11word. JMP and JSR know
+// their target only for absolute (@#a) and relative (a) operands.
+
+static int flow(unsigned long int address, uint64_t pc, uint64_t *target)
+{
+    uint16_t operation = pdp11word(address);
+    uint8_t high = operation >> 8;
+    *target = DASM_NO_TARGET;
+    if ((operation & 0177770) == 0000200 || operation == 0000002 || operation == 0000006) return DASM_FLOW_RET;
+    if ((operation & 0177700) == 0000100 || (operation & 0177000) == 0004000) {
+        if ((operation & 077) == 037) *target = pdp11word(address + 2);
+        else if ((operation & 077) == 067) *target = (uint16_t)(pc + 4 + pdp11word(address + 2));
+        return (operation & 0177000) == 0004000 ? DASM_FLOW_CALL : DASM_FLOW_JUMP;
+    }
+    if ((high >= 0x01 && high <= 0x07) || (high >= 0x80 && high <= 0x87)) {
+        *target = pc + 2 + 2 * (int8_t)(operation & 0xFF);
+        return high == 0x01 ? DASM_FLOW_JUMP : DASM_FLOW_BRANCH;
+    }
+    if ((operation & 0177000) == 0077000) {
+        *target = pc + 2 - 2 * (operation & 077);
+        return DASM_FLOW_BRANCH;
+    }
+    return DASM_FLOW_NEXT;
+}
+
+int decodePDP11(const struct dasm_ctx *ctx, const uint8_t *data, uint64_t remaining, uint64_t offset, char *outbuf, struct dasm_insn *insn)
 {
-    struct editor *e = editor();
+    char pdpout[1000];
+    uint8_t pad[6];
+    data = dasm_pad(pad, sizeof(pad), data, remaining);
+    unsigned long int address = (unsigned long int)data;
     unsigned long int start = address, i;
     unsigned long int finish = address + 2;
     uint16_t operation = pdp11word(start);
@@ -225,9 +251,19 @@ char * decodePDP11(unsigned long int address, char *outbuf, int *lendis, unsigne
     sprintf(pdpout, ".word 0x%04X", (unsigned int)operation);
 
 end:
+    if (finish - start > remaining) return dasm_truncated(data, remaining, finish - start, outbuf, insn);
     memcpy(outbuf,pdpout,strlen(pdpout));
     outbuf[strlen(pdpout)] = '\0';
-    *lendis = finish - start;
-    return outbuf;
+    if (insn) {
+        uint64_t target;
+        int f = flow(start, offset, &target);
+        dasm_insn_text(insn, outbuf, f, target);
+        insn->length = finish - start;
+    }
+    return finish - start;
 }
 
+const struct be_decoder be_decoder_pdp11 = {
+    "pdp11", NULL, decodePDP11, dasm_decode_batch, 6, 2
+};
+
@@ -1,3 +1,7 @@
 #include <stdint.h>
 
-char * decodePDP11(unsigned long int address, char *outbuf, int *len, unsigned long int offset0);
+#include "../../dasm/decoder.h"
+
+int decodePDP11(const struct dasm_ctx *ctx, const uint8_t *data, uint64_t remaining, uint64_t offset, char *outbuf, struct dasm_insn *insn);
+
+extern const struct be_decoder be_decoder_pdp11;
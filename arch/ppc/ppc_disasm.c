@@ -2770,21 +2770,65 @@ ppc_word *PPC_Disassemble(struct DisasmPara_PPC *dp)
   return (dp->instr + 1);
 }
 
-    struct DisasmPara_PPC dp;
-    char ppc_opcode[640];
-    char ppc_operands[2560];
+// No state outside the call: batch listings decode on several threads.
 
-char * decodePPC(unsigned long int start, char *outbuf, int *lendis, unsigned long int offset0)
+/* control flow from the primary/extended opcode, BO and LK */
+static int ppc_flow(struct DisasmPara_PPC *dp, ppc_word in, uint64_t pc, uint64_t *target)
 {
+  int always = (PPCGETD(in) & 0x14) == 0x14;
+  int lk = in & 1;
+
+  *target = DASM_NO_TARGET;
+  switch (PPCGETIDX(in)) {
+  case 18:
+    always = 1;
+    /* fall through */
+  case 16:
+    if (dp->type == PPCINSTR_BRANCH)
+      *target = (in & 2) ? (uint64_t)(int32_t)dp->displacement
+                         : pc + (int32_t)dp->displacement;
+    return lk ? DASM_FLOW_CALL : always ? DASM_FLOW_JUMP : DASM_FLOW_BRANCH;
+  case 19:
+    switch ((in >> 1) & 0x3ff) {
+    case 16:   /* bclr */
+      return lk ? DASM_FLOW_CALL : always ? DASM_FLOW_RET : DASM_FLOW_BRANCH;
+    case 528:  /* bcctr */
+      return lk ? DASM_FLOW_CALL : always ? DASM_FLOW_JUMP : DASM_FLOW_BRANCH;
+    case 50:   /* rfi */
+      return DASM_FLOW_RET;
+    }
+  }
+  return DASM_FLOW_NEXT;
+}
+
+int decodePPC(const struct dasm_ctx *ctx, const uint8_t *data, uint64_t remaining, uint64_t offset, char *text, struct dasm_insn *insn)
+{
+     struct DisasmPara_PPC dp;
+     char ppc_opcode[640];
+     char ppc_operands[2560];
+     ppc_word word;
+     if (remaining < sizeof(ppc_word)) return dasm_truncated(data, remaining, sizeof(ppc_word), text, insn);
+     memcpy(&word, data, sizeof(ppc_word));
      dp.opcode = ppc_opcode;
      dp.operands = ppc_operands;
-     dp.iaddr = (unsigned int *)start;
-     dp.instr = (unsigned int *)start;
+     dp.iaddr = (unsigned int *)offset;
+     dp.instr = &word;
+     dp.type = PPCINSTR_OTHER;
      PPC_Disassemble(&dp);
-     memcpy(outbuf,ppc_opcode,strlen(ppc_opcode));
-     memcpy(outbuf+strlen(ppc_opcode)," ",1);
-     memcpy(outbuf+strlen(ppc_opcode)+1,ppc_operands,strlen(ppc_operands));
-     memcpy(outbuf+strlen(ppc_opcode)+1+strlen(ppc_operands),"\0",1);
-     *lendis = sizeof(ppc_word);
-     return outbuf;
+     memcpy(text,ppc_opcode,strlen(ppc_opcode));
+     memcpy(text+strlen(ppc_opcode)," ",1);
+     memcpy(text+strlen(ppc_opcode)+1,ppc_operands,strlen(ppc_operands));
+     memcpy(text+strlen(ppc_opcode)+1+strlen(ppc_operands),"\0",1);
+     if (insn) {
+       uint64_t target;
+       ppc_word in = (ppc_word)data[0]<<24 | data[1]<<16 | data[2]<<8 | data[3];
+       int flow = ppc_flow(&dp, in, offset, &target);
+       dasm_insn_text(insn, text, flow, target);
+       insn->length = sizeof(ppc_word);
+     }
+     return sizeof(ppc_word);
 }
+
+const struct be_decoder be_decoder_ppc = {
+    "ppc", NULL, decodePPC, dasm_decode_batch, 4, 4
+};
@@ -22,6 +22,8 @@
 #ifndef PPC_DISASM_H
 #define PPC_DISASM_H
 
+#include "../../dasm/decoder.h"
+
 #define PPC_GEKKO
 
 /* version/revision */
@@ -137,5 +139,7 @@ struct DisasmPara_PPC {
 
 extern ppc_word *PPC_Disassemble(struct DisasmPara_PPC *);
 
-char * decodePPC(unsigned long int start, char *outbuf, int *lendis, unsigned long int offset0);
+int decodePPC(const struct dasm_ctx *ctx, const uint8_t *data, uint64_t remaining, uint64_t offset, char *text, struct dasm_insn *insn);
+
+extern const struct be_decoder be_decoder_ppc;
 
@@ -23,7 +23,6 @@
  * THE SOFTWARE.
  */
 
-#include "../../editor.h"
 #include "riscv-disas.h"
 
 typedef struct {
@@ -2260,9 +2259,9 @@ void disasm_inst(char *buf, size_t buflen, rv_isa isa, uint64_t pc, rv_inst inst
     decode_inst_format(buf, buflen, 0, &dec);
 }
 
-rv_isa bitness(struct editor* e)
+rv_isa bitness(int seg_size)
 {
-    switch (e->seg_size) {
+    switch (seg_size) {
         case 32:  return rv32;
         case 64:  return rv64;
         case 128: return rv128;
@@ -2270,13 +2269,54 @@ rv_isa bitness(struct editor* e)
     }
 }
 
-static rv_inst rvinst = 0;
+/* control flow, taken after decompression and before pseudo lifting */
 
-char *decodeRISCV(unsigned long int address, char *outbuf, int *lendis, unsigned long int offset0) {
-     struct editor *e = editor();
-     *lendis = 0;
-     inst_fetch((uint8_t *)address, &rvinst, lendis);
-     disasm_inst(outbuf, sizeof(outbuf), bitness(e), address, rvinst);
-     if (!*lendis) *lendis = 2;
-     return outbuf;
+static int rv_flow(const rv_decode *dec, uint64_t *target)
+{
+    *target = DASM_NO_TARGET;
+    switch (dec->op) {
+    case rv_op_jal:
+        *target = dec->pc + dec->imm;
+        return dec->rd == rv_ireg_zero ? DASM_FLOW_JUMP : DASM_FLOW_CALL;
+    case rv_op_jalr:
+        if (dec->rd != rv_ireg_zero) return DASM_FLOW_CALL;
+        return dec->rs1 == rv_ireg_ra && dec->imm == 0 ? DASM_FLOW_RET : DASM_FLOW_JUMP;
+    case rv_op_beq: case rv_op_bne: case rv_op_blt:
+    case rv_op_bge: case rv_op_bltu: case rv_op_bgeu:
+        *target = dec->pc + dec->imm;
+        return DASM_FLOW_BRANCH;
+    case rv_op_uret: case rv_op_sret: case rv_op_mret:
+        return DASM_FLOW_RET;
+    default:
+        return DASM_FLOW_NEXT;
+    }
+}
+
+int decodeRISCV(const struct dasm_ctx *ctx, const uint8_t *data, uint64_t remaining, uint64_t offset, char *text, struct dasm_insn *insn) {
+     rv_inst rvinst = 0;
+     int length = 0;
+     rv_isa isa = bitness(ctx->seg_size);
+     rv_decode dec = { .pc = offset };
+     uint64_t target;
+     if (remaining < 2) return dasm_truncated(data, remaining, 2, text, insn);
+     length = inst_length(data[0]);
+     if ((uint64_t)length > remaining) return dasm_truncated(data, remaining, length, text, insn);
+     inst_fetch((uint8_t *)data, &rvinst, &length);
+     if (!length) length = 2;
+     dec.inst = rvinst;
+     decode_inst_opcode(&dec, isa);
+     decode_inst_operands(&dec);
+     decode_inst_decompress(&dec, isa);
+     int flow = rv_flow(&dec, &target);
+     decode_inst_lift_pseudo(&dec);
+     decode_inst_format(text, DASM_TEXT_MAX, 0, &dec);
+     if (insn) {
+         dasm_insn_text(insn, text, flow, target);
+         insn->length = length;
+     }
+     return length;
 }
+
+const struct be_decoder be_decoder_riscv = {
+    "riscv", NULL, decodeRISCV, dasm_decode_batch, 8, 2
+};
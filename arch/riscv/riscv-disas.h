@@ -33,6 +33,8 @@
 #include <inttypes.h>
 #include <string.h>
 
+#include "../../dasm/decoder.h"
+
 /* types */
 
 typedef uint64_t rv_inst;
@@ -516,6 +518,8 @@ typedef struct {
 int inst_length(rv_inst inst);
 void inst_fetch(uint8_t *data, rv_inst *instp, int *length);
 void disasm_inst(char *buf, size_t buflen, rv_isa isa, uint64_t pc, rv_inst inst);
-char * decodeRISCV(unsigned long int address, char *outbuf, int *lendis, unsigned long int offset0);
+int decodeRISCV(const struct dasm_ctx *ctx, const uint8_t *data, uint64_t remaining, uint64_t offset, char *text, struct dasm_insn *insn);
+
+extern const struct be_decoder be_decoder_riscv;
 
 #endif
@@ -3,23 +3,51 @@
 
 #include "sh4dis.h"
 #include "sh4asm_txt_emit.h"
+#include "sh4.h"
 
-#define SH4ASM_TXT_LEN 228
-static char sh4asm_disas[SH4ASM_TXT_LEN];
-unsigned sh4asm_disas_len;
-static void clear_asm(void) { sh4asm_disas_len = 0; }
-static void neo_asm_emit(char ch) {
-    if (sh4asm_disas_len < SH4ASM_TXT_LEN)
-        sh4asm_disas[sh4asm_disas_len++] = ch;
+static int flow(uint16_t inst, uint64_t pc, uint64_t *target)
+{
+     int32_t disp8 = (int8_t)(inst & 0xff), disp12 = ((int32_t)(inst & 0xfff) ^ 0x800) - 0x800;
+     *target = DASM_NO_TARGET;
+     switch (inst >> 12) {
+         case 0xa: *target = pc + 4 + disp12 * 2; return DASM_FLOW_JUMP;     /* bra */
+         case 0xb: *target = pc + 4 + disp12 * 2; return DASM_FLOW_CALL;     /* bsr */
+         case 0x8:
+             switch ((inst >> 8) & 0xf) {
+                 case 0x9: case 0xb: case 0xd: case 0xf:                     /* bt, bf, bt/s, bf/s */
+                     *target = pc + 4 + disp8 * 2; return DASM_FLOW_BRANCH;
+             }
+             return DASM_FLOW_NEXT;
+         case 0x4:
+             if ((inst & 0xff) == 0x2b) return DASM_FLOW_JUMP;               /* jmp @Rn */
+             if ((inst & 0xff) == 0x0b) return DASM_FLOW_CALL;               /* jsr @Rn */
+             return DASM_FLOW_NEXT;
+         case 0x0:
+             if (inst == 0x000b || inst == 0x002b) return DASM_FLOW_RET;     /* rts, rte */
+             if ((inst & 0xff) == 0x23) return DASM_FLOW_JUMP;               /* braf Rn */
+             if ((inst & 0xff) == 0x03) return DASM_FLOW_CALL;               /* bsrf Rn */
+             return DASM_FLOW_NEXT;
+     }
+     return DASM_FLOW_NEXT;
 }
 
-char * decodeSH4(unsigned long int address, char *outbuf, int *lendis, unsigned long int offset0)
+int decodeSH4(const struct dasm_ctx *ctx, const uint8_t *data, uint64_t remaining, uint64_t offset, char *text, struct dasm_insn *insn)
 {
-     uint16_t inst16 = (uint16_t)*((unsigned long int *)address);
-     memset(sh4_buf, 0, sizeof(sh4_buf));
-     clear_asm();
-     sh4asm_disas_inst(inst16, neo_asm_emit, 0);
-     memcpy(outbuf,sh4asm_disas,sh4asm_disas_len);
-     memcpy(outbuf+sh4asm_disas_len,"\0",1);
-     *lendis = 2;
+     if (remaining < 2) return dasm_truncated(data, remaining, 2, text, insn);
+     uint16_t inst16 = (uint16_t)(data[0] | data[1] << 8);
+     struct sh4asm_txt txt = { .len = 0 };
+     sh4asm_disas_inst(inst16, &txt, 0);
+     memcpy(text,txt.text,txt.len);
+     memcpy(text+txt.len,"\0",1);
+     if (insn) {
+         uint64_t target;
+         int f = flow(inst16, offset, &target);
+         dasm_insn_text(insn, text, f, target);
+         insn->length = 2;
+     }
+     return 2;
 }
+
+const struct be_decoder be_decoder_sh4 = {
+    "sh4", NULL, decodeSH4, dasm_decode_batch, 2, 2
+};
@@ -1,4 +1,8 @@
 #include <stdint.h>
+
+#include "../../dasm/decoder.h"
 #include <string.h>
 
-char * decodeSH4(unsigned long int address, char *outbuf, int *lendis, unsigned long int offset0);
+int decodeSH4(const struct dasm_ctx *ctx, const uint8_t *data, uint64_t remaining, uint64_t offset, char *text, struct dasm_insn *insn);
+
+extern const struct be_decoder be_decoder_sh4;
@@ -37,12 +37,22 @@
 #include <stdio.h>
 #include <stdint.h>
 
-typedef void(*sh4asm_txt_emit_handler_func)(char);
+// Text goes to a buffer owned by the caller instead of through a callback,
+// so decodes running on different threads share nothing.
+
+#define SH4ASM_TXT_LEN 228
+
+struct sh4asm_txt {
+    char text[SH4ASM_TXT_LEN];
+    unsigned len;
+};
+
+typedef struct sh4asm_txt *sh4asm_txt_emit_handler_func;
 
 static void
 sh4asm_txt_emit_str(sh4asm_txt_emit_handler_func em, char const *txt) {
-    while (*txt)
-        em(*txt++);
+    while (*txt && em->len < SH4ASM_TXT_LEN - 1)
+        em->text[em->len++] = *txt++;
 }
 
 static char const *sh4asm_gen_reg_str(unsigned idx) {
@@ -96,52 +106,52 @@ static char const *sh4asm_fv_reg_str(unsigned idx) {
     return names[(idx >> 2) & 3];
 }
 
-static char const *sh4asm_imm8_str(unsigned imm8, unsigned shift) {
+static void sh4asm_imm8_str(sh4asm_txt_emit_handler_func em, unsigned imm8, unsigned shift) {
     // TODO: pad output to two digits
-    static char buf[8];
+    char buf[8];
     snprintf(buf, sizeof(buf), "0x%x", //"0x%02x",
              imm8 & ((256 << shift) - 1) & ~((1 << shift) - 1));
     buf[7] = '\0';
-    return buf;
+    sh4asm_txt_emit_str(em, buf);
 }
 
-static char const *sh4asm_imm12_str(int imm12, uint32_t pc) {
-    static char buf[32];
+static void sh4asm_imm12_str(sh4asm_txt_emit_handler_func em, int imm12, uint32_t pc) {
+    char buf[32];
     snprintf(buf, sizeof(buf), "0x%08x", (int)(pc + imm12));
     buf[31] = '\0';
-    return buf;
+    sh4asm_txt_emit_str(em, buf);
 }
 
-static char const *sh4asm_disp8_pc_str(int disp8, uint32_t pc) {
-    static char buf[32];
+static void sh4asm_disp8_pc_str(sh4asm_txt_emit_handler_func em, int disp8, uint32_t pc) {
+    char buf[32];
     snprintf(buf, sizeof(buf), "0x%08x", disp8);
     buf[31] = '\0';
-    return buf;
+    sh4asm_txt_emit_str(em, buf);
 }
 
-static char const *sh4asm_disp8_pc_comment(int disp8, uint32_t pc) {
-    static char buf[32];
+static void sh4asm_disp8_pc_comment(sh4asm_txt_emit_handler_func em, int disp8, uint32_t pc) {
+    char buf[32];
     snprintf(buf, sizeof(buf), " ! 0x%08x", (int)(pc + disp8));
     buf[31] = '\0';
-    return buf;
+    sh4asm_txt_emit_str(em, buf);
 }
 
-static char const *sh4asm_disp4_str(unsigned disp4, unsigned shift) {
+static void sh4asm_disp4_str(sh4asm_txt_emit_handler_func em, unsigned disp4, unsigned shift) {
     // convert to hex
-    static char buf[8];
+    char buf[8];
     snprintf(buf, sizeof(buf), "%d", //"0x%x",
              disp4 & ((16 << shift) - 1) & ~((1 << shift)-1));
     buf[7] = '\0';
-    return buf;
+    sh4asm_txt_emit_str(em, buf);
 }
 
-static char const *sh4asm_disp8_str(unsigned disp8, unsigned shift) {
+static void sh4asm_disp8_str(sh4asm_txt_emit_handler_func em, unsigned disp8, unsigned shift) {
     // TODO: pad output to two hex digits
-    static char buf[8];
+    char buf[8];
     snprintf(buf, sizeof(buf), "%d", //"0x%02x",
              disp8 & ((256 << shift) - 1) & ~((1 << shift)-1));
     buf[7] = '\0';
-    return buf;
+    sh4asm_txt_emit_str(em, buf);
 }
 
 // OP
@@ -239,7 +249,7 @@ static char const *sh4asm_disp8_str(unsigned disp8, unsigned shift) {
     static inline void sh4asm_txt_##op##_imm8_##reg(sh4asm_txt_emit_handler_func em, \
                                                     unsigned imm8) {    \
         sh4asm_txt_emit_str(em, lit " #");                                         \
-        sh4asm_txt_emit_str(em, sh4asm_imm8_str(imm8, imm_shift));                 \
+        sh4asm_imm8_str(em, imm8, imm_shift);                 \
         sh4asm_txt_emit_str(em, ", " #reg);                                        \
     }
 
@@ -249,7 +259,7 @@ static char const *sh4asm_disp8_str(unsigned disp8, unsigned shift) {
     sh4asm_txt_##op##_imm8_a_##reg1##_##reg2(sh4asm_txt_emit_handler_func em, \
                                              unsigned imm8) {           \
         sh4asm_txt_emit_str(em, lit " #");                                         \
-        sh4asm_txt_emit_str(em, sh4asm_imm8_str(imm8, imm_shift));                 \
+        sh4asm_imm8_str(em, imm8, imm_shift);                 \
         sh4asm_txt_emit_str(em, ", @(" #reg1 ", " #reg2 ")");                      \
     }
 
@@ -259,7 +269,7 @@ static char const *sh4asm_disp8_str(unsigned disp8, unsigned shift) {
     sh4asm_txt_##op##_##reg1##_a_disp8_##reg2(sh4asm_txt_emit_handler_func em, \
                                               unsigned disp8) {         \
         sh4asm_txt_emit_str(em, lit " " #reg1 ", @(");                             \
-        sh4asm_txt_emit_str(em, sh4asm_disp8_str(disp8, disp_shift));              \
+        sh4asm_disp8_str(em, disp8, disp_shift);              \
         sh4asm_txt_emit_str(em, ", " #reg2 ")");                                   \
     }
 
@@ -269,7 +279,7 @@ static char const *sh4asm_disp8_str(unsigned disp8, unsigned shift) {
     sh4asm_txt_##op##_a_disp8_##reg1##_##reg2(sh4asm_txt_emit_handler_func em, \
                                               unsigned disp8) {         \
         sh4asm_txt_emit_str(em, lit " @(");                                        \
-        sh4asm_txt_emit_str(em, sh4asm_disp8_str(disp8, disp_shift));              \
+        sh4asm_disp8_str(em, disp8, disp_shift);              \
         sh4asm_txt_emit_str(em, ", " #reg1 "), " #reg2);                           \
     }
 
@@ -279,9 +289,9 @@ static char const *sh4asm_disp8_str(unsigned disp8, unsigned shift) {
     sh4asm_txt_##op##_a_disp8_pc_##reg2(sh4asm_txt_emit_handler_func em, \
                                         int disp8, uint32_t pc) {       \
         sh4asm_txt_emit_str(em, lit " @(");                             \
-        sh4asm_txt_emit_str(em, sh4asm_disp8_pc_str(disp8, pc));        \
+        sh4asm_disp8_pc_str(em, disp8, pc);        \
         sh4asm_txt_emit_str(em, ", pc), " #reg2);                       \
-        sh4asm_txt_emit_str(em, sh4asm_disp8_pc_comment(disp8, pc));    \
+        sh4asm_disp8_pc_comment(em, disp8, pc);    \
     }
 
 // OP disp8
@@ -290,8 +300,8 @@ static char const *sh4asm_disp8_str(unsigned disp8, unsigned shift) {
     sh4asm_txt_##op##_disp8_pc(sh4asm_txt_emit_handler_func em,         \
                                int disp8, uint32_t pc) {                \
         sh4asm_txt_emit_str(em, lit " ");                               \
-        sh4asm_txt_emit_str(em, sh4asm_disp8_pc_str(disp8, pc));        \
-        sh4asm_txt_emit_str(em, sh4asm_disp8_pc_comment(disp8, pc));    \
+        sh4asm_disp8_pc_str(em, disp8, pc);        \
+        sh4asm_disp8_pc_comment(em, disp8, pc);    \
     }
 
 // OP #imm8
@@ -299,7 +309,7 @@ static char const *sh4asm_disp8_str(unsigned disp8, unsigned shift) {
     static inline void sh4asm_txt_##op##_imm8(sh4asm_txt_emit_handler_func em, \
                                               unsigned imm8) {          \
         sh4asm_txt_emit_str(em, lit " #");                                         \
-        sh4asm_txt_emit_str(em, sh4asm_imm8_str(imm8, imm_shift));                 \
+        sh4asm_imm8_str(em, imm8, imm_shift);                 \
     }
 
 // OP offs12
@@ -308,7 +318,7 @@ static char const *sh4asm_disp8_str(unsigned disp8, unsigned shift) {
     sh4asm_txt_##op##_offs12(sh4asm_txt_emit_handler_func em,           \
                              int imm12, uint32_t pc) {                  \
         sh4asm_txt_emit_str(em, lit " ");                               \
-        sh4asm_txt_emit_str(em, sh4asm_imm12_str(imm12, pc));           \
+        sh4asm_imm12_str(em, imm12, pc);           \
     }
 
 // OP #imm8, Rn
@@ -316,7 +326,7 @@ static char const *sh4asm_disp8_str(unsigned disp8, unsigned shift) {
     static inline void sh4asm_txt_##op##_imm8_rn(sh4asm_txt_emit_handler_func em, \
                                                  unsigned imm8, unsigned rn) { \
         sh4asm_txt_emit_str(em, lit " #");                                         \
-        sh4asm_txt_emit_str(em, sh4asm_imm8_str(imm8, imm_shift));                 \
+        sh4asm_imm8_str(em, imm8, imm_shift);                 \
         sh4asm_txt_emit_str(em, ", ");                                             \
         sh4asm_txt_emit_str(em, sh4asm_gen_reg_str(rn));                           \
     }
@@ -327,10 +337,10 @@ static char const *sh4asm_disp8_str(unsigned disp8, unsigned shift) {
     sh4asm_txt_##op##_a_disp8_pc_rn(sh4asm_txt_emit_handler_func em,    \
                                     int disp8, unsigned pc, unsigned rn) { \
         sh4asm_txt_emit_str(em, lit " @(");                             \
-        sh4asm_txt_emit_str(em, sh4asm_disp8_pc_str(disp8, pc));        \
+        sh4asm_disp8_pc_str(em, disp8, pc);        \
         sh4asm_txt_emit_str(em, ", pc), ");                             \
         sh4asm_txt_emit_str(em, sh4asm_gen_reg_str(rn));                \
-        sh4asm_txt_emit_str(em, sh4asm_disp8_pc_comment(disp8, pc));    \
+        sh4asm_disp8_pc_comment(em, disp8, pc);    \
     }
 
 // OP Rm, Rn
@@ -549,7 +559,7 @@ static char const *sh4asm_disp8_str(unsigned disp8, unsigned shift) {
     sh4asm_txt_##op##_##reg##_a_disp4_rn(sh4asm_txt_emit_handler_func em, \
                                          unsigned disp4, unsigned rn) { \
         sh4asm_txt_emit_str(em, lit " " #reg ", @(");                              \
-        sh4asm_txt_emit_str(em, sh4asm_disp4_str(disp4, disp_shift));              \
+        sh4asm_disp4_str(em, disp4, disp_shift);              \
         sh4asm_txt_emit_str(em, ", ");                                             \
         sh4asm_txt_emit_str(em, sh4asm_gen_reg_str(rn));                           \
         sh4asm_txt_emit_str(em, ")");                                              \
@@ -561,7 +571,7 @@ static char const *sh4asm_disp8_str(unsigned disp8, unsigned shift) {
     sh4asm_txt_##op##_a_disp4_rm_##reg(sh4asm_txt_emit_handler_func em, \
                                        unsigned disp4, unsigned rm) {   \
         sh4asm_txt_emit_str(em, lit " @(");                                        \
-        sh4asm_txt_emit_str(em, sh4asm_disp4_str(disp4, disp_shift));              \
+        sh4asm_disp4_str(em, disp4, disp_shift);              \
         sh4asm_txt_emit_str(em, ", ");                                             \
         sh4asm_txt_emit_str(em, sh4asm_gen_reg_str(rm));                           \
         sh4asm_txt_emit_str(em, "), " #reg);                                       \
@@ -575,7 +585,7 @@ static char const *sh4asm_disp8_str(unsigned disp8, unsigned shift) {
         sh4asm_txt_emit_str(em, lit " ");                                          \
         sh4asm_txt_emit_str(em, sh4asm_gen_reg_str(rm));                           \
         sh4asm_txt_emit_str(em, ", @(");                                           \
-        sh4asm_txt_emit_str(em, sh4asm_disp4_str(disp4, disp_shift));              \
+        sh4asm_disp4_str(em, disp4, disp_shift);              \
         sh4asm_txt_emit_str(em, ", ");                                             \
         sh4asm_txt_emit_str(em, sh4asm_gen_reg_str(rn));                           \
         sh4asm_txt_emit_str(em, ")");                                              \
@@ -587,7 +597,7 @@ static char const *sh4asm_disp8_str(unsigned disp8, unsigned shift) {
     sh4asm_txt_##op##_a_disp4_rm_rn(sh4asm_txt_emit_handler_func em,    \
                                     unsigned disp4, unsigned rm, unsigned rn) { \
         sh4asm_txt_emit_str(em, lit " @(");                                        \
-        sh4asm_txt_emit_str(em, sh4asm_disp4_str(disp4, disp_shift));              \
+        sh4asm_disp4_str(em, disp4, disp_shift);              \
         sh4asm_txt_emit_str(em, ", ");                                             \
         sh4asm_txt_emit_str(em, sh4asm_gen_reg_str(rm));                           \
         sh4asm_txt_emit_str(em, "), ");                                            \
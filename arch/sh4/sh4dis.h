@@ -47,8 +47,8 @@
  *
  ******************************************************************************/
 
-// this must match the asm_emit_handler_func typedef in sh4_asm_emit.h
-typedef void(*sh4asm_disas_emit_func)(char);
+// this must match the sh4asm_txt_emit_handler_func typedef in sh4asm_txt_emit.h
+typedef struct sh4asm_txt *sh4asm_disas_emit_func;
 
 SH4ASM_STATIC void
 sh4asm_disas_inst(uint16_t inst, sh4asm_disas_emit_func em, uint32_t pc);
@@ -68,15 +68,13 @@ sh4asm_disas_inst(uint16_t inst, sh4asm_disas_emit_func em, uint32_t pc);
     (SH4ASM_SET_TO_BIT(last + 1) & ~SH4ASM_SET_TO_BIT(first))
 
 #define NON_INST_BUF_LEN 64
-char sh4_buf[NON_INST_BUF_LEN];
 
 SH4ASM_STATIC void
 sh4asm_opcode_non_inst_(unsigned const *quads, sh4asm_disas_emit_func em) {
-    memset(sh4_buf, 0, sizeof(sh4_buf));
+    char buf[NON_INST_BUF_LEN];
     // TODO: make sure the quads get printed in the right order
-    snprintf(sh4_buf, NON_INST_BUF_LEN, ".byte %x%x %x%x\0", quads[1], quads[0], quads[3], quads[2]);
-    char const *outp = sh4_buf;
-    while (*outp) em(*outp++);
+    snprintf(buf, NON_INST_BUF_LEN, ".byte %x%x %x%x", quads[1], quads[0], quads[3], quads[2]);
+    sh4asm_txt_emit_str(em, buf);
 }
 
 SH4ASM_STATIC void
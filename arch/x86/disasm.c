@@ -44,7 +44,6 @@
 #include "regdis.h"
 #include "disp8.h"
 
-#include "../../editor.h"
 
 #define fetch_safe(_start, _ptr, _size, _need, _op)         \
     do {                                                    \
@@ -1114,8 +1113,61 @@ static const char * const condition_name[16] = {
     "s", "ns", "pe", "po", "l", "nl", "ng", "g"
 };
 
+/*
+ * Fill in what the matched template says about the instruction, for
+ * callers that want more than the text.
+ */
+static void describe(struct dasm_insn *out, const struct itemplate *t,
+                     const insn *ins, uint64_t target)
+{
+    char name[32];
+    int i = t->opcode;
+    int len = snprintf(name, sizeof name, "%s%s", nasm_insn_names[i],
+                       i >= FIRST_COND_OPCODE ? condition_name[ins->condition] : "");
+
+    out->mnemonic = dasm_mnemonic_id(name, len);
+    out->target = target;
+    switch (i) {
+    case I_CALL:
+        out->flow = DASM_FLOW_CALL;
+        break;
+    case I_JMP: case I_JMPE:
+        out->flow = DASM_FLOW_JUMP;
+        break;
+    case I_Jcc: case I_JCXZ: case I_JECXZ: case I_JRCXZ:
+    case I_LOOP: case I_LOOPE: case I_LOOPNE: case I_LOOPNZ: case I_LOOPZ:
+        out->flow = DASM_FLOW_BRANCH;
+        break;
+    case I_RET: case I_RETF: case I_RETN: case I_RETW: case I_RETFW:
+    case I_RETNW: case I_RETD: case I_RETFD: case I_RETND: case I_RETQ:
+    case I_RETFQ: case I_RETNQ: case I_IRET: case I_IRETD: case I_IRETQ:
+    case I_IRETW: case I_SYSRET:
+        out->flow = DASM_FLOW_RET;
+        break;
+    default:
+        out->flow = DASM_FLOW_NEXT;
+        out->target = DASM_NO_TARGET;
+        break;
+    }
+
+    out->operands = t->operands < DASM_OPERANDS ? t->operands : DASM_OPERANDS;
+    memset(out->operand, DASM_OPND_NONE, sizeof out->operand);
+    for (i = 0; i < out->operands; i++) {
+        opflags_t f = t->opd[i];
+        const operand *o = &ins->oprs[i];
+        if ((f & (REGISTER | FPUREG)) || (o->segment & SEG_RMREG))
+            out->operand[i] = DASM_OPND_REG;
+        else if ((f & IMMEDIATE) && (o->segment & SEG_RELATIVE))
+            out->operand[i] = DASM_OPND_REL;
+        else if (!(UNITY & ~f) || (f & IMMEDIATE))
+            out->operand[i] = DASM_OPND_IMM;
+        else
+            out->operand[i] = DASM_OPND_MEM;
+    }
+}
+
 int32_t disasm(uint8_t *data, int32_t data_size, char *output, int outbufsize, int segsize,
-               int64_t offset, int autosync, iflag_t *prefer)
+               int64_t offset, int autosync, iflag_t *prefer, struct dasm_insn *out)
 {
     const struct itemplate * const *p, * const *best_p;
     const struct disasm_index *ix;
@@ -1131,6 +1183,7 @@ int32_t disasm(uint8_t *data, int32_t data_size, char *output, int outbufsize, i
     struct prefix_info prefix;
     bool end_prefix;
     bool is_evex;
+    uint64_t target = DASM_NO_TARGET;
 
     memset(&ins, 0, sizeof ins);
 
@@ -1434,6 +1487,9 @@ int32_t disasm(uint8_t *data, int32_t data_size, char *output, int outbufsize, i
                 offs &= 0xffff;
             else if (segsize != 64)
                 offs &= 0xffffffff;
+            /* a RIP-relative memory operand is where the target is read from */
+            if (t & IMMEDIATE)
+                target = offs;
 
             /*
              * add sync marker, if autosync is on
@@ -1674,6 +1730,8 @@ int32_t disasm(uint8_t *data, int32_t data_size, char *output, int outbufsize, i
         strncpy(output, segover, 2);
         output[2] = ' ';
     }
+    if (out)
+        describe(out, *p, &ins, target);
     return length;
 }
 
@@ -1762,18 +1820,37 @@ int32_t eatbyte(uint8_t *data, char *output, int outbufsize, int segsize)
 }
 
 
-char * decodeEM64T(unsigned long int start, char *outbuf, int *lendis, unsigned long int offset0)
+static void x86_init(void)
+{
+    nasm_ctype_init();
+    init_sync();
+}
+
+int decodeEM64T(const struct dasm_ctx *ctx, const uint8_t *data, uint64_t remaining,
+                uint64_t offset, char *text, struct dasm_insn *insn)
 {
-    uint32_t nextsync, synclen, initskip = 0L;
-    bool autosync = false;
     iflag_t prefer;
-    struct editor* e = editor();
-    int offset = start;
+    int32_t length;
+    uint8_t pad[INSN_MAX];
+
+    if (!remaining)
+        return dasm_truncated(data, remaining, 1, text, insn);
+    /* matches() reads operands unchecked, so a short tail goes through pad;
+       fetch_safe() wants a byte beyond the last one it fetches */
+    data = dasm_pad(pad, INSN_MAX, data, remaining);
     iflag_clear_all(&prefer);
-    char *qx = (char *)start;
-    char *px = &e->contents[0] + e->content_length;
-    *lendis = disasm((uint8_t *)qx, INSN_MAX, outbuf, 4096, e->seg_size, offset, autosync, &prefer);
-    if (!*lendis || *lendis > (px - qx) || ((nextsync || synclen) && (uint32_t)*lendis > nextsync - offset))
-         *lendis = eatbyte((uint8_t *) qx, outbuf, 4096, e->seg_size);
-    return outbuf;
+    length = disasm((uint8_t *)data, remaining < INSN_MAX ? (int32_t)remaining + 1 : INSN_MAX,
+                    text, DASM_TEXT_MAX, ctx->seg_size, offset, false, &prefer, insn);
+    if (!length || (uint64_t)length > remaining) {
+        length = eatbyte((uint8_t *)data, text, DASM_TEXT_MAX, ctx->seg_size);
+        if (insn)
+            dasm_insn_text(insn, text, DASM_FLOW_NEXT, DASM_NO_TARGET);
+    }
+    if (insn)
+        insn->length = length;
+    return length;
 }
+
+const struct be_decoder be_decoder_x86 = {
+    "x86", x86_init, decodeEM64T, dasm_decode_batch, INSN_MAX, 1
+};
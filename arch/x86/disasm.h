@@ -42,13 +42,17 @@
 #include "nctype.h"
 
 #include "iflag.h"
+#include "../../dasm/decoder.h"
 
 #define INSN_MAX 32             /* one instruction can't be longer than this */
 
 int32_t disasm(uint8_t *data, int32_t data_size, char *output, int outbufsize, int segsize,
-               int64_t offset, int autosync, iflag_t *prefer);
+               int64_t offset, int autosync, iflag_t *prefer, struct dasm_insn *out);
 int32_t eatbyte(uint8_t *data, char *output, int outbufsize, int segsize);
 
-char * decodeEM64T(unsigned long int start, char *outbuf, int *lendis, unsigned long int offset0);
+int decodeEM64T(const struct dasm_ctx *ctx, const uint8_t *data, uint64_t remaining,
+                uint64_t offset, char *text, struct dasm_insn *insn);
+
+extern const struct be_decoder be_decoder_x86;
 
 #endif
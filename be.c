@@ -2,21 +2,24 @@
 // Synrc Research (c) 2022-2025
 // 5HT DHARMA License
 
+#include <errno.h>
+#include <inttypes.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 #include <getopt.h>
 #include <signal.h>
 #include <stdint.h>
+#include <time.h>
 
 #include "editor.h"
+#include "term/event.h"
 #include "term/terminal.h"
 #include "dasm/dasm.h"
-#include "arch/arm32/armv7.h"
 
 volatile sig_atomic_t resizeflag;
 
-ARMSTATE arm;
-
 static void editor_exit() {
     struct editor* e = editor();
     editor_free(e);
@@ -28,7 +31,8 @@ static void editor_exit() {
 static void print_help(const char* explanation) {
     fprintf(stderr,
         "%s"\
-        "Usage: be [-vhdbao] <filename>\n"\
+        "Usage: be [-vhdbaof] <filename>\n"\
+        "       be -D [-ab] [-s start] [-l length] <filename>\n"\
         "\n"
         "Options:\n"
         "    -v           Get version information\n"
@@ -37,6 +41,10 @@ static void print_help(const char* explanation) {
         "    -b bitness   CPU Bitness\n"
         "    -a arch      1:EM64T, 2:ARM, 3:RISC-V, 4:PPC, 5:SH-4, 6:M68K, 7:MIPS, 8:PDP-11, 9:nVidia\n"
         "    -o octets    Octets per screen for HEX view\n"
+        "    -f fps       Maximum screen refreshes per second (default 60)\n"
+        "    -D           Disassemble to stdout and exit, no terminal needed\n"
+        "    -s start     Batch start offset (0x for hex)\n"
+        "    -l length    Batch length in bytes (default: to end of file)\n"
         "\n"
         "Report bugs to <be@5ht.co>\n", explanation);
 }
@@ -48,18 +56,61 @@ void print_version() {
 static void handle_term_resize(int sig) {
     (void)(sig);
     resizeflag = 1;
+    event_wake();
+}
+
+static uint64_t parse_offset(const char* s) {
+    char* end;
+    errno = 0;
+    uint64_t x = strtoull(s, &end, 0);
+    if (errno || *end != '\0') {
+        print_help("Error: bad offset or length.\n");
+        exit(1);
+    }
+    return x;
+}
+
+// be -D: the file goes through the decoders front to back and the listing
+// to stdout. Nothing here touches the terminal.
+
+static int batch(const char* file, int arch, int bitness, uint64_t start, uint64_t length) {
+    if (access(file, R_OK) == -1) {
+        perror(file);
+        return 1;
+    }
+    struct editor* e = editor_init();
+    editor_openfile(e, file);
+    e->seg_size = bitness;
+    e->arch = arch;
+    if (start > e->content_length) {
+        fprintf(stderr, "Start 0x%" PRIx64 " is past the end of %s\n", start, file);
+        return 1;
+    }
+    dasm_init();
+    bool ok = dasm_print(e, start, length, STDOUT_FILENO);
+    editor_free(e);
+    return ok ? 0 : 1;
+}
+
+static uint64_t clock_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
 }
 
 static void resize_term() {
     struct editor *e = editor();
     clear_screen();
     get_window_size(&(e->screen_rows), &(e->screen_cols));
+    dasm_window_resize(e->screen_rows - 2);
 }
 
 int main(int argc, char* argv[]) {
     char* file = NULL;
-    int ch = 0, bitness = 64, opl = 24, view = 0, arch = ARCH_INTEL;
-    while ((ch = getopt(argc, argv, "vhdb:o:a:")) != -1) {
+    int ch = 0, bitness = 64, opl = 24, view = 0, arch = ARCH_INTEL, fps = FRAME_RATE;
+    bool headless = false;
+    uint64_t start = 0, length = 0;
+    while ((ch = getopt(argc, argv, "vhdDb:o:a:f:s:l:")) != -1) {
         switch (ch) {
             case 'v': print_version(); return 0;
             case 'h': print_help(""); exit(0); break;
@@ -67,6 +118,10 @@ int main(int argc, char* argv[]) {
             case 'b': bitness = str2int(optarg, 16, 128, 16); break;
             case 'a': arch = (enum dasm_arch)str2int(optarg, 0, 10, 1); break;
             case 'd': view = VIEW_ASM; break;
+            case 'f': fps = str2int(optarg, 1, 1000, FRAME_RATE); break;
+            case 'D': headless = true; break;
+            case 's': start = parse_offset(optarg); break;
+            case 'l': length = parse_offset(optarg); break;
             default: print_help(""); exit(1); break;
         }
     }
@@ -77,6 +132,9 @@ int main(int argc, char* argv[]) {
     }
 
     file = argv[optind];
+    if (headless) return batch(file, arch, bitness, start, length);
+
+    event_init();
 
     struct sigaction act;
     memset(&act, 0, sizeof(struct sigaction));
@@ -95,16 +153,34 @@ int main(int argc, char* argv[]) {
     e->octets_per_line = opl;
     e->seg_size = bitness;
     e->arch = arch;
+    e->frame_rate = fps;
     editor_setview(e, view ? VIEW_ASM : VIEW_HEX);
-    nasm_init(e);
-    disasm_init(&arm, 0);
+    dasm_init();
 
+    // Sleeps until a key, a resize or a worker wakeup, and draws at most one
+    // frame per 1/frame_rate seconds: whatever arrives before the next frame
+    // is due is handled first and shares it.
+
+    uint64_t frame_due = 0;
+    bool redraw = true;
     while (true) {
-        editor_refresh_screen(e);
-        editor_process_keypress(e);
         if (resizeflag == 1) {
-            resize_term();
             resizeflag = 0;
+            resize_term();
+            redraw = true;
+        }
+        uint64_t now = clock_ms();
+        if (redraw && now >= frame_due) {
+            editor_search_poll(e);
+            editor_refresh_screen(e);
+            frame_due = now + 1000 / e->frame_rate;
+            redraw = false;
+        }
+        int events = event_wait(redraw ? (int) (frame_due - now) : -1);
+        if (events & EVENT_WAKE) redraw = true;
+        if (events & EVENT_KEY) {
+            do editor_process_keypress(e); while (resizeflag == 0 && key_pending(0));
+            redraw = true;
         }
     }
 
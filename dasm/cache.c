@@ -0,0 +1,110 @@
+// BE: INFOSEC BINARY HEX EDITOR WITH DASM
+// Synrc Research (c) 2022-2025
+// 5HT DHARMA License
+
+#include <string.h>
+
+#include "cache.h"
+
+#define NIL UINT32_MAX
+#define BUCKETS (DASM_CACHE_LINES * 2)
+
+// Buckets hash the offset alone, so every (arch, bitness) variant of an
+// offset shares a chain and a small edit probes only the offsets it hits.
+
+static struct dasm_line lines[DASM_CACHE_LINES];
+static uint32_t buckets[BUCKETS];
+static uint32_t head = NIL, tail = NIL;
+static uint32_t used;
+static bool ready;
+
+static uint32_t bucket(uint64_t offset) {
+    return (uint32_t) ((offset * 0x9E3779B97F4A7C15ull) >> 32) & (BUCKETS - 1);
+}
+
+static void cache_init() {
+    for (size_t i = 0; i < BUCKETS; i++) buckets[i] = NIL;
+    ready = true;
+}
+
+static void lru_unlink(uint32_t i) {
+    if (lines[i].prev != NIL) lines[lines[i].prev].next = lines[i].next; else head = lines[i].next;
+    if (lines[i].next != NIL) lines[lines[i].next].prev = lines[i].prev; else tail = lines[i].prev;
+}
+
+static void lru_push(uint32_t i) {
+    lines[i].prev = NIL;
+    lines[i].next = head;
+    if (head != NIL) lines[head].prev = i; else tail = i;
+    head = i;
+}
+
+// Unlinks line i from its bucket and the LRU list; its slot is reused by
+// swapping the last used slot into it.
+
+static void cache_drop(uint32_t i) {
+    uint32_t* p = &buckets[bucket(lines[i].offset)];
+    while (*p != i) p = &lines[*p].chain;
+    *p = lines[i].chain;
+    lru_unlink(i);
+
+    uint32_t last = --used;
+    if (i == last) return;
+    p = &buckets[bucket(lines[last].offset)];
+    while (*p != last) p = &lines[*p].chain;
+    *p = i;
+    lines[i] = lines[last];
+    if (lines[i].prev != NIL) lines[lines[i].prev].next = i; else head = i;
+    if (lines[i].next != NIL) lines[lines[i].next].prev = i; else tail = i;
+}
+
+const struct dasm_line* dasm_cache_get(int arch, int seg_size, uint64_t offset) {
+    if (!ready) return NULL;
+    for (uint32_t i = buckets[bucket(offset)]; i != NIL; i = lines[i].chain) {
+        struct dasm_line* l = &lines[i];
+        if (l->offset != offset || l->arch != arch || l->seg_size != seg_size) continue;
+        if (head != i) {
+            lru_unlink(i);
+            lru_push(i);
+        }
+        return l;
+    }
+    return NULL;
+}
+
+void dasm_cache_put(int arch, int seg_size, uint64_t offset, int length, const char* text) {
+    if (!ready) cache_init();
+    if (used == DASM_CACHE_LINES) cache_drop(tail);
+    uint32_t i = used++;
+    struct dasm_line* l = &lines[i];
+    l->offset = offset;
+    l->arch = arch;
+    l->seg_size = seg_size;
+    l->length = length;
+    size_t n = strlen(text);
+    if (n >= DASM_CACHE_TEXT) n = DASM_CACHE_TEXT - 1;
+    memcpy(l->text, text, n);
+    l->text[n] = '\0';
+    uint32_t* b = &buckets[bucket(offset)];
+    l->chain = *b;
+    *b = i;
+    lru_push(i);
+}
+
+// Drops every line that could have read a byte in [start, end). Small
+// ranges probe their buckets, larger ones sweep the whole cache.
+
+void dasm_cache_invalidate(uint64_t start, uint64_t end) {
+    if (used == 0 || start >= end) return;
+    uint64_t from = start > DASM_CACHE_REACH - 1 ? start - (DASM_CACHE_REACH - 1) : 0;
+    if (end - from <= DASM_CACHE_LINES) {
+        for (uint64_t offset = from; offset < end; offset++)
+            for (uint32_t i = buckets[bucket(offset)]; i != NIL; )
+                if (lines[i].offset == offset) { cache_drop(i); i = buckets[bucket(offset)]; }
+                else i = lines[i].chain;
+    } else {
+        for (uint32_t i = 0; i < used; )
+            if (lines[i].offset >= from && lines[i].offset < end) cache_drop(i);
+            else i++;
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef XT_DASM_CACHE_H
+#define XT_DASM_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define DASM_CACHE_LINES 4096
+#define DASM_CACHE_TEXT  256
+#define DASM_CACHE_REACH 32     // bytes a decoder may read past the offset
+
+// Decoded instructions keyed by (arch, bitness, offset), bounded and
+// evicted least recently used first. A cursor move over lines already on
+// screen decodes nothing; edits drop every line whose bytes they touch.
+
+struct dasm_line {
+    uint64_t offset;
+    int arch;
+    int seg_size;
+    int length;
+    char text[DASM_CACHE_TEXT];
+    uint32_t prev;     // LRU list, most recent at the head
+    uint32_t next;
+    uint32_t chain;    // hash bucket chain
+};
+
+const struct dasm_line* dasm_cache_get(int arch, int seg_size, uint64_t offset);
+void dasm_cache_put(int arch, int seg_size, uint64_t offset, int length, const char* text);
+void dasm_cache_invalidate(uint64_t start, uint64_t end);
+
+#endif
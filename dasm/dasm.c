@@ -4,6 +4,7 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <inttypes.h>
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -12,140 +13,294 @@
 #include "../term/buffer.h"
 #include "../term/terminal.h"
 #include "../hex/hex.h"
+#include "../dasm/cache.h"
 #include "../dasm/dasm.h"
+#include "../dasm/decoder.h"
+#include "../dasm/index.h"
+#include "../search/pool.h"
 #include "../editor.h"
 
-#include "../arch/x86/disasm.h"
-#include "../arch/arm64/armadillo.h"
-#include "../arch/arm32/armv7.h"
-#include "../arch/riscv/riscv-disas.h"
-#include "../arch/ppc/ppc_disasm.h"
-#include "../arch/mips/mips.h"
-#include "../arch/m68k/m68k.h"
-#include "../arch/sh4/sh4.h"
-#include "../arch/pdp11/pdp11.h"
-#include "../arch/nv/nv.h"
-
-#define LINES 140
-#define DUMP  32
-#define ADDR  16
-#define CODE  256
-#define ADDRWIN 16
 #define DUMPWIN 32
-#define CODEWIN 64
+#define DASM_SPAN DASM_CACHE_REACH
+#define DASM_TEXT DASM_TEXT_MAX
 
 int  dump_win = DUMPWIN;
-int  addr[LINES][ADDR];
-int  codelen[LINES];
-int  dumplen[LINES];
-unsigned char dump[LINES][DUMP*20];
-unsigned char code[LINES][CODE];
 
-void nasm_init(struct editor* e) { nasm_ctype_init();  init_sync(); }
+// Visible window: where each screen row's instruction starts and how long
+// it is, sized to the terminal. Text and bytes are not kept; a frame draws
+// them straight from the decode cache (or the decoder) and the file.
 
-void setup_instruction(int i, struct editor* e, struct charbuf* b,
-    uint64_t offset, uint8_t *data, int datalen, char *insn)
+static struct {
+    int rows;
+    int cap;
+    uint64_t* offset;
+    int* length;
+} win;
+
+void dasm_window_resize(int rows)
 {
-    dumplen[i] = datalen;
-    memcpy(&dump[i],data,dumplen[i]);
-    codelen[i] = strlen(insn) + 1;
-    memcpy(&code[i],insn,codelen[i]);
+    if (rows < 1) rows = 1;
+    if (rows > win.cap) {
+        win.offset = realloc(win.offset, rows * sizeof(uint64_t));
+        win.length = realloc(win.length, rows * sizeof(int));
+        if (win.offset == NULL || win.length == NULL) { perror("Unable to grow disassembly window"); exit(1); }
+        win.cap = rows;
+    }
+    win.rows = rows;
 }
 
+void dasm_init() { be_decoder_init(); }
+
 void draw_instruction(int i, struct editor* e, struct charbuf* b,
-    uint64_t offset, uint8_t *data, int datalen, char *insn)
+    uint64_t offset, const uint8_t *data, int datalen, const char *insn)
 {
-    char hex[ 32 + 1];
-    int  hexlen = 0;
-
     if (i + 1 == e->cursor_y) charbuf_appendf(b, "\x1b[1;97m\x1b[45m");
     else charbuf_appendf(b, "\x1b[0;93m\x1b[0;104m");
-    charbuf_appendf(b, "%016x\x1b[0m ", offset);
+    charbuf_appendf(b, "%016" PRIx64 "\x1b[0m ", offset);
 
-    for (int j = 0; j < dumplen[i] && j < dump_win; j++)
+    for (int j = 0; j < datalen && j < dump_win; j++)
         if (e->cursor_y - 1 == i && e->cursor_x - 1 == j)
         {
             charbuf_appendf(b, "\x1b[1;37m\x1b[43m");
             memset(hexstr()+1, '\0', 1);
-            if (hexstr_idx() == 1 && e->mode == MODE_REPLACE)
-                hexlen = snprintf(hex, sizeof(hex), "%02x", dump[i][j] & 0xF | hex2bin(hexstr()) & 0xF << 4);
-                charbuf_appendf(b, "%02X", (unsigned char)dump[i][j]);
+            charbuf_appendf(b, "%02X", data[j]);
             charbuf_appendf(b, "\x1b[4;94m\x1b[49m");
         } else {
             charbuf_appendf(b, "\x1b[4;94m\x1b[49m");
-            charbuf_appendf(b, "%02X", dump[i][j]);
+            charbuf_appendf(b, "%02X", data[j]);
         }
 
     charbuf_appendf(b, "\x1b[0m ");
     charbuf_appendf(b, "\x1b[0;93m\x1b[0;104m");
-    for (int j = 0; j < dump_win - 2 * dumplen[i]; j++) charbuf_appendf(b, " ");
+    for (int j = 0; j < dump_win - 2 * datalen; j++) charbuf_appendf(b, " ");
 
     charbuf_appendf(b, "\x1b[0m ");
     if (i + 1 == e->cursor_y) charbuf_appendf(b, "\x1b[1;97m\x1b[45m");
     else charbuf_appendf(b, "\x1b[0;93m\x1b[0;104m");
-    charbuf_appendf(b, "%s", &code[i]);
-    for (int j = 0; j < 62 - strlen(code[i]); j++) charbuf_appendf(b, " ");
+    charbuf_appendf(b, "%s", insn);
+    for (int j = (int) strlen(insn); j < 62; j++) charbuf_appendf(b, " ");
     charbuf_appendf(b, "\r\n");
 
 }
 
-int offset_at_cursor_dasm(struct editor* e) {
-    int offset = e->offset_dasm;
-    for (int i = 0; i < e->cursor_y - 1; i++) offset += dumplen[i];
-    offset += e->cursor_x - 1;
-    if (offset <= 0) return 0;
+uint64_t offset_at_cursor_dasm(struct editor* e) {
+    if (e->content_length == 0) return 0;
+    uint64_t offset = win.offset[e->cursor_y - 1] + e->cursor_x - 1;
     if (offset >= e->content_length) return e->content_length - 1;
     return offset;
 }
 
-char *decodeARM(unsigned long int start, char *outbuf, int *lendis, unsigned long int offset) {
-    struct editor *e = editor();
-   if (e->seg_size < 64) decodeARM32 (start, outbuf, lendis, offset);
-   else decodeARM64 (start, outbuf, lendis, offset);
+// Decoder context for e as it stands; callers keep it on their own stack.
+
+static struct dasm_ctx dasm_context(struct editor* e)
+{
+    return (struct dasm_ctx) { e->arch, e->seg_size, e->content_length };
+}
+
+// Decodes through the arch's be_decoder from a span read at offset, which
+// holds file bytes up to ctx->end only; an arch without one shows nothing
+// and advances a byte.
+
+static int decode(const struct dasm_ctx *ctx, const uint8_t *data, uint64_t offset, char *text, struct dasm_insn *insn)
+{
+    const struct be_decoder* d = be_decoder(ctx->arch, ctx->seg_size);
+    uint64_t remaining = offset < ctx->end ? ctx->end - offset : 0;
+    if (remaining > DASM_SPAN) remaining = DASM_SPAN;
+    if (d != NULL) return d->decode_one(ctx, data, remaining, offset, text, insn);
+    text[0] = '\0';
+    if (insn) {
+        dasm_insn_text(insn, text, DASM_FLOW_NEXT, DASM_NO_TARGET);
+        insn->length = 1;
+    }
+    return 1;
+}
+
+// Length of the instruction at offset, through the decode cache. Never
+// zero, so a stream walk always makes progress.
+
+int dasm_length(struct editor* e, uint64_t offset)
+{
+    int lendis = 0;
+    char outbuf[DASM_TEXT], span[DASM_SPAN];
+    const struct dasm_line* l = dasm_cache_get(e->arch, e->seg_size, offset);
+    if (l != NULL) return l->length > 0 ? l->length : 1;
+    struct dasm_ctx ctx = dasm_context(e);
+    const char *q = editor_span(e, offset, DASM_SPAN, span);
+    lendis = decode(&ctx, (const uint8_t *) q, offset, outbuf, NULL);
+    outbuf[DASM_CACHE_TEXT - 1] = '\0';
+    dasm_cache_put(e->arch, e->seg_size, offset, lendis, outbuf);
+    return lendis;
 }
 
-char *decode(unsigned long int start, char *outbuf, int *lendis, unsigned long int offset)
+void dasm_invalidate(uint64_t start, uint64_t end)
 {
-    struct editor *e = editor();
-    switch (e->arch) {
-         case ARCH_INTEL: decodeEM64T (start, outbuf, lendis, offset); break;
-         case ARCH_ARM:   decodeARM   (start, outbuf, lendis, offset); break;
-         case ARCH_PPC:   decodePPC   (start, outbuf, lendis, offset); break;
-         case ARCH_RISCV: decodeRISCV (start, outbuf, lendis, offset); break;
-         case ARCH_SH4:   decodeSH4   (start, outbuf, lendis, offset); break;
-         case ARCH_M68K:  decodeM68K  (start, outbuf, lendis, offset); break;
-         case ARCH_MIPS:  decodeMIPS  (start, outbuf, lendis, offset); break;
-         case ARCH_PDP11: decodePDP11 (start, outbuf, lendis, offset); break;
-         case ARCH_NVIDIA:   decodeNV (start, outbuf, lendis, offset); break;
-         default: break;
-     }
-     return outbuf;
+    dasm_cache_invalidate(start, end);
+    dasm_index_invalidate(start, end);
 }
 
+// Lays out the window from offset_dasm and, given a buffer, draws each
+// row as it goes. Lines come from the decode cache when they can; only
+// misses decode.
+
 void disassemble_screen(struct editor* e, struct charbuf* b)
 {
     int lendis=0;
-    unsigned long int offset=0;
-    char outbuf[2048], *q;
-    offset = e->offset_dasm;
-    q = &e->contents[offset];
-    for (int i = 0; i < e->screen_rows - 2; i++) if (offset < e->content_length)
+    char outbuf[DASM_TEXT], span[DASM_SPAN];
+    const char *q, *text;
+    uint64_t offset = e->offset_dasm;
+    struct dasm_ctx ctx = dasm_context(e);
+    dasm_window_resize(e->screen_rows - 2);
+    for (int i = 0; i < win.rows; i++)
     {
-        decode((unsigned long)q, outbuf, &lendis, offset);
-        setup_instruction(i, e, b, offset, (uint8_t *) q, lendis, outbuf);
-        q += lendis;
+        win.offset[i] = offset;
+        win.length[i] = 0;
+        if (offset >= e->content_length) {
+            if (b != NULL) charbuf_appendf(b, "\x1b[0m\x1b[0K\r\n");
+            continue;
+        }
+        q = editor_span(e, offset, DASM_SPAN, span);
+        const struct dasm_line* l = dasm_cache_get(e->arch, e->seg_size, offset);
+        if (l != NULL) {
+            lendis = l->length;
+            text = l->text;
+        } else {
+            lendis = decode(&ctx, (const uint8_t *) q, offset, outbuf, NULL);
+            outbuf[DASM_CACHE_TEXT - 1] = '\0';
+            dasm_cache_put(e->arch, e->seg_size, offset, lendis, outbuf);
+            text = outbuf;
+        }
+        win.length[i] = lendis;
+        if (b != NULL) draw_instruction(i, e, b, offset, (const uint8_t *) q, lendis, text);
         offset += lendis;
     }
 }
 
+// Batch listing: decodes [start, start + length) linearly and writes one
+// "offset bytes text" line per instruction to fd, a megabyte at a time.
+// No cache and no terminal; false when fd stops taking output.
+
+#define DASM_PRINT_BUF (1 << 20)
+#define DASM_CHUNK (256 << 10)
+
+// Decodes the instruction at offset and appends its line; returns its length.
+// Bytes from end on are out of range, so an instruction crossing it is cut
+// to .byte there.
+
+static int print_line(struct editor* e, struct charbuf* b, uint64_t offset, uint64_t end)
+{
+    static const char digits[] = "0123456789ABCDEF";
+    int lendis = 0;
+    char outbuf[DASM_TEXT], span[DASM_SPAN], line[32 + 2 * DASM_SPAN + 2];
+    struct dasm_ctx ctx = dasm_context(e);
+    ctx.end = end;
+    const char *q = editor_span(e, offset, DASM_SPAN, span);
+    lendis = decode(&ctx, (const uint8_t *) q, offset, outbuf, NULL);
+    int n = snprintf(line, sizeof(line), "%016" PRIx64 " ", offset);
+    for (int j = 0; j < lendis && j < DASM_SPAN; j++) {
+        line[n++] = digits[(unsigned char) q[j] >> 4];
+        line[n++] = digits[(unsigned char) q[j] & 0xF];
+    }
+    while (n < 17 + dump_win) line[n++] = ' ';
+    line[n++] = ' ';
+    charbuf_append(b, line, n);
+    charbuf_append(b, outbuf, strlen(outbuf));
+    charbuf_append(b, "\n", 1);
+    return lendis;
+}
+
+// Instruction width when every boundary is known up front, so chunks can
+// be decoded independently; 0 for variable-length encodings.
+
+static int dasm_fixed_width(struct editor* e)
+{
+    const struct be_decoder* d = be_decoder(e->arch, e->seg_size);
+    return d != NULL && d->max_insn_len == d->alignment ? d->alignment : 0;
+}
+
+struct sweep {
+    struct editor* e;
+    uint64_t from;
+    uint64_t end;
+    struct charbuf** out;
+};
+
+// Runs on a pool thread: one DASM_CHUNK of the batch into its own buffer.
+
+static void sweep_chunk(void* arg, size_t task, size_t worker)
+{
+    struct sweep* x = arg;
+    (void) worker;
+    struct charbuf* b = x->out[task];
+    uint64_t offset = x->from + (uint64_t) task * DASM_CHUNK;
+    uint64_t to = x->end - offset < DASM_CHUNK ? x->end : offset + DASM_CHUNK;
+    charbuf_reset(b);
+    while (offset < to) offset += print_line(x->e, b, offset, x->end);
+}
+
+// Fixed-width ISAs are cut into aligned chunks decoded on the pool, a
+// couple per thread at a time, and written out in order.
+
+static bool print_parallel(struct editor* e, uint64_t start, uint64_t end, int fd)
+{
+    size_t batch = pool_size() * 2;
+    struct sweep x = { e, start, end, calloc(batch, sizeof(struct charbuf*)) };
+    if (x.out == NULL) { perror("Unable to allocate listing buffers"); exit(1); }
+    for (size_t i = 0; i < batch; i++) x.out[i] = charbuf_create();
+
+    bool ok = true;
+    for (; ok && x.from < end; x.from += (uint64_t) batch * DASM_CHUNK) {
+        uint64_t left = (end - x.from + DASM_CHUNK - 1) / DASM_CHUNK;
+        size_t tasks = left < batch ? left : batch;
+        pool_run(tasks, sweep_chunk, &x);
+        for (size_t i = 0; ok && i < tasks; i++) ok = write_all(fd, x.out[i]->contents, x.out[i]->len) == 0;
+    }
+
+    for (size_t i = 0; i < batch; i++) charbuf_free(x.out[i]);
+    free(x.out);
+    return ok;
+}
+
+bool dasm_print(struct editor* e, uint64_t start, uint64_t length, int fd)
+{
+    uint64_t end = length && length < e->content_length - start ? start + length : e->content_length;
+    int width = dasm_fixed_width(e);
+    if (width && DASM_CHUNK % width == 0 && end - start > DASM_CHUNK && pool_size() > 1)
+        return print_parallel(e, start, end, fd);
+
+    struct charbuf* b = charbuf_create();
+    charbuf_reserve(b, DASM_PRINT_BUF);
+    for (uint64_t offset = start; offset < end; ) {
+        offset += print_line(e, b, offset, end);
+        if (b->len >= DASM_PRINT_BUF - DASM_TEXT - 256) {
+            if (write_all(fd, b->contents, b->len) != 0) { charbuf_free(b); return false; }
+            charbuf_reset(b);
+        }
+    }
+    bool ok = write_all(fd, b->contents, b->len) == 0;
+    charbuf_free(b);
+    return ok;
+}
+
 void editor_render_dasm(struct editor* e, struct charbuf* b)
 {
     disassemble_screen(e, b);
-    int offset = e->offset_dasm;
-    for (int i = 0; i < e->screen_rows - 2; i++) {
-        draw_instruction(i, e, b, offset, (uint8_t *)&dump[i][0], dumplen[i], &code[i][0]);
-        offset += dumplen[i];
-    }
+}
+
+// Rows past either edge of the screen scroll the stream by as many
+// instructions and re-lay the screen, so the wrap logic below sees the
+// lengths of the lines it lands on.
+
+static void dasm_scroll_rows(struct editor* e)
+{
+    int rows = e->screen_rows - 2;
+    if (e->cursor_y > rows) {
+        editor_scroll_dasm(e, e->cursor_y - rows);
+        e->cursor_y = rows;
+    } else if (e->cursor_y < 1 && e->offset_dasm > 0) {
+        editor_scroll_dasm(e, e->cursor_y - 1);
+        e->cursor_y = 1;
+    } else return;
+    disassemble_screen(e, NULL);
 }
 
 void editor_move_cursor_dasm(struct editor* e, int dir, int amount)
@@ -155,17 +310,20 @@ void editor_move_cursor_dasm(struct editor* e, int dir, int amount)
         case KEY_LEFT:  e->cursor_x-=amount; break; case KEY_RIGHT: e->cursor_x+=amount; break;
     }
 
+    dasm_scroll_rows(e);
     if (e->cursor_y <= 1) e->cursor_y = 1;
     if (e->cursor_y > e->screen_rows - 2) e->cursor_y = e->screen_rows - 2;
-    if (e->cursor_x <= 1 && e->cursor_y <= 1 && e->line <= 0) { e->cursor_x = e->cursor_y = 1; return; }
+    if (e->cursor_x <= 1 && e->cursor_y <= 1 && e->offset_dasm == 0) { e->cursor_x = e->cursor_y = 1; return; }
     if (e->cursor_x < 1) {
         if (dir == KEY_LEFT) e->cursor_y--; else e->cursor_y++;
-        if (e->cursor_y >= 1) e->cursor_x = dumplen[e->cursor_y - 1];
-    } else if (e->cursor_x > dumplen[e->cursor_y - 1] && (dir == KEY_RIGHT || dir == KEY_LEFT)) {
+        dasm_scroll_rows(e);
+        if (e->cursor_y >= 1) e->cursor_x = win.length[e->cursor_y - 1];
+    } else if (e->cursor_x > win.length[e->cursor_y - 1] && (dir == KEY_RIGHT || dir == KEY_LEFT)) {
         e->cursor_y++;
         e->cursor_x = 1;
-    } else if (e->cursor_x > dumplen[e->cursor_y - 1] && (dir == KEY_DOWN || dir == KEY_UP)) {
-        e->cursor_x = dumplen[e->cursor_y - 1];
+        dasm_scroll_rows(e);
+    } else if (e->cursor_x > win.length[e->cursor_y - 1] && (dir == KEY_DOWN || dir == KEY_UP)) {
+        e->cursor_x = win.length[e->cursor_y - 1];
     }
     if (e->cursor_y <= 1) e->cursor_y = 1;
     if (e->cursor_x <= 1) e->cursor_x = 1;
@@ -175,17 +333,53 @@ void editor_move_cursor_dasm(struct editor* e, int dir, int amount)
 void editor_replace_byte_dasm(struct editor* e, char x) {
     hexstr_set(0,0); hexstr_set(1,0); hexstr_set(2,0);
     hexstr_idx_set(0);
-    unsigned int offset = offset_at_cursor_dasm(e);
-    unsigned char prev = e->contents[offset];
-    e->contents[offset] = x;
+    uint64_t offset = offset_at_cursor_dasm(e);
+    editor_write_bytes(e, offset, &x, 1);
     editor_refresh_screen(e);
     editor_move_cursor(e, KEY_RIGHT, 1);
-    editor_statusmessage(e, STATUS_INFO, "Replaced byte at offset %09x with %02x", offset, (unsigned char) x);
-    e->dirty = true;
+    editor_statusmessage(e, STATUS_INFO, "Replaced byte at offset %09" PRIx64 " with %02x", offset, (unsigned char) x);
 }
 
 void editor_insert_byte_dasm(struct editor* e, char x, bool after) {
+    hexstr_set(0,0); hexstr_set(1,0); hexstr_set(2,0);
+    hexstr_idx_set(0);
+    editor_insert_byte_at_offset(e, offset_at_cursor_dasm(e), x, after);
 }
 
 void editor_scroll_dasm(struct editor* e, int units) {
+    if (units < 0) e->offset_dasm = dasm_back(e, e->offset_dasm, -units);
+    else if (e->offset_dasm < e->content_length) e->offset_dasm = dasm_forward(e, e->offset_dasm, units);
+}
+
+// Moves the view to where the instruction under the cursor branches or
+// calls, as its decoder reports it.
+
+void editor_follow_dasm(struct editor* e)
+{
+    char outbuf[DASM_TEXT], span[DASM_SPAN];
+    struct dasm_insn insn;
+    struct dasm_ctx ctx = dasm_context(e);
+    uint64_t offset = win.offset[e->cursor_y - 1];
+    if (offset >= e->content_length) return;
+    const char *q = editor_span(e, offset, DASM_SPAN, span);
+    decode(&ctx, (const uint8_t *) q, offset, outbuf, &insn);
+    if (insn.target == DASM_NO_TARGET) {
+        editor_statusmessage(e, STATUS_WARNING, "No target: %s", outbuf);
+        return;
+    }
+    editor_scroll_to_offset_dasm(e, insn.target);
+    if (insn.target < e->content_length)
+        editor_statusmessage(e, STATUS_INFO, "%s 0x%" PRIx64, dasm_mnemonic(insn.mnemonic), insn.target);
+}
+
+// Puts the instruction holding offset on the top row, cursor on the byte.
+
+void editor_scroll_to_offset_dasm(struct editor* e, uint64_t offset) {
+    if (offset >= e->content_length) {
+        editor_statusmessage(e, STATUS_ERROR, "Out of range: 0x%09" PRIx64 " (%" PRIu64 ")", offset, offset);
+        return;
+    }
+    e->offset_dasm = dasm_back(e, offset + 1, 1);
+    e->cursor_y = 1;
+    e->cursor_x = offset - e->offset_dasm + 1;
 }
@@ -13,11 +13,17 @@
 
 #include "../editor.h"
 
-void nasm_init();
+void dasm_init();
+void dasm_window_resize(int rows);
 void editor_render_dasm(struct editor* e, struct charbuf* b);
 void editor_move_cursor_dasm(struct editor* e, int dir, int amount);
 void editor_replace_byte_dasm(struct editor* e, char x);
 void editor_insert_byte_dasm(struct editor* e, char x, bool after);
 void editor_scroll_dasm(struct editor* e, int units);
+void editor_scroll_to_offset_dasm(struct editor* e, uint64_t offset);
+void editor_follow_dasm(struct editor* e);
+int dasm_length(struct editor* e, uint64_t offset);
+void dasm_invalidate(uint64_t start, uint64_t end);
+bool dasm_print(struct editor* e, uint64_t start, uint64_t length, int fd);
 
 #endif
@@ -0,0 +1,160 @@
+// BE: INFOSEC BINARY HEX EDITOR WITH DASM
+// Synrc Research (c) 2022-2025
+// 5HT DHARMA License
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../editor.h"
+#include "../dasm/decoder.h"
+#include "../dasm/decoders.h"
+
+#define MNEMONICS 4096       // power of two; id 0 is "none"
+#define MNEMONIC_LEN 24
+
+static const struct be_decoder* const decoders[] = {
+    [ARCH_INTEL]  = &be_decoder_x86,
+    [ARCH_ARM]    = &be_decoder_arm64,
+    [ARCH_RISCV]  = &be_decoder_riscv,
+    [ARCH_PPC]    = &be_decoder_ppc,
+    [ARCH_SH4]    = &be_decoder_sh4,
+    [ARCH_M68K]   = &be_decoder_m68k,
+    [ARCH_MIPS]   = &be_decoder_mips,
+    [ARCH_PDP11]  = &be_decoder_pdp11,
+    [ARCH_NVIDIA] = &be_decoder_nv,
+};
+
+const struct be_decoder* be_decoder(int arch, int seg_size)
+{
+    if (arch == ARCH_ARM && seg_size < 64) return &be_decoder_arm32;
+    if (arch <= 0 || arch >= (int) (sizeof(decoders) / sizeof(decoders[0]))) return NULL;
+    return decoders[arch];
+}
+
+void be_decoder_init()
+{
+    for (size_t i = 0; i < sizeof(decoders) / sizeof(decoders[0]); i++)
+        if (decoders[i] != NULL && decoders[i]->init != NULL) decoders[i]->init();
+}
+
+int dasm_decode_batch(const struct be_decoder* d, const struct dasm_ctx* ctx,
+                      const uint8_t* data, uint64_t size, uint64_t offset,
+                      struct dasm_insn* insn, uint8_t* length, int max)
+{
+    char text[DASM_TEXT_MAX];
+    uint64_t at = 0;
+    int n = 0;
+    bool last = offset + size >= ctx->end;
+    while (n < max && at < size && (last || at + d->max_insn_len <= size)) {
+        length[n] = d->decode_one(ctx, data + at, size - at, offset + at, text, insn ? &insn[n] : NULL);
+        at += length[n++];
+    }
+    return n;
+}
+
+// Mnemonics are interned once into one table for all decoders, so an id
+// means the same name whatever the arch.
+
+static struct {
+    pthread_mutex_t lock;
+    int count;
+    char name[MNEMONICS][MNEMONIC_LEN];
+} mnemonics = { PTHREAD_MUTEX_INITIALIZER, 0, { "" } };
+
+uint16_t dasm_mnemonic_id(const char* name, int len)
+{
+    if (len <= 0) return 0;
+    if (len >= MNEMONIC_LEN) len = MNEMONIC_LEN - 1;
+    uint32_t h = 2166136261u;
+    for (int i = 0; i < len; i++) h = (h ^ (uint8_t) name[i]) * 16777619u;
+    uint16_t id = 0;
+    pthread_mutex_lock(&mnemonics.lock);
+    for (uint32_t k = 0; k < MNEMONICS - 1; k++) {
+        uint32_t slot = 1 + (h + k) % (MNEMONICS - 1);
+        char* s = mnemonics.name[slot];
+        if (s[0] == '\0') {
+            if (mnemonics.count + 1 >= MNEMONICS - 1) break;
+            memcpy(s, name, len);
+            s[len] = '\0';
+            mnemonics.count++;
+            id = slot;
+            break;
+        }
+        if (strncmp(s, name, len) == 0 && s[len] == '\0') { id = slot; break; }
+    }
+    pthread_mutex_unlock(&mnemonics.lock);
+    return id;
+}
+
+const char* dasm_mnemonic(uint16_t id)
+{
+    if (id == 0 || id >= MNEMONICS) return "";
+    pthread_mutex_lock(&mnemonics.lock);
+    const char* s = mnemonics.name[id];
+    pthread_mutex_unlock(&mnemonics.lock);
+    return s;
+}
+
+// Fills insn for a decoder that only knows its flow and target: mnemonic
+// and operand kinds come from the text it printed. Operands split at top
+// level commas; the last immediate becomes the target when there is one.
+
+void dasm_insn_text(struct dasm_insn* insn, const char* text, int flow, uint64_t target)
+{
+    const char* p = text;
+    while (*p == ' ') p++;
+    const char* m = p;
+    while (*p && *p != ' ' && *p != '\t') p++;
+    insn->mnemonic = dasm_mnemonic_id(m, (int) (p - m));
+    insn->flow = flow;
+    insn->target = target;
+    insn->operands = 0;
+    memset(insn->operand, DASM_OPND_NONE, sizeof(insn->operand));
+
+    int rel = -1;
+    while (*p && insn->operands < DASM_OPERANDS) {
+        while (*p == ' ' || *p == '\t' || *p == ',') p++;
+        if (*p == '\0' || *p == '!' || *p == ';' || (*p == '/' && p[1] == '/')) break;
+        int kind = DASM_OPND_REG, depth = 0;
+        if (*p == '#' || *p == '$' || *p == '-' || *p == '+' || (*p >= '0' && *p <= '9')) kind = DASM_OPND_IMM;
+        for (; *p && (depth > 0 || *p != ','); p++) {
+            if (*p == '[' || *p == '(' || *p == '{') { depth++; if (*p != '{') kind = DASM_OPND_MEM; }
+            else if (*p == ']' || *p == ')' || *p == '}') depth--;
+            else if (*p == '@') kind = DASM_OPND_MEM;
+        }
+        if (kind == DASM_OPND_IMM) rel = insn->operands;
+        insn->operand[insn->operands++] = kind;
+    }
+    if (target != DASM_NO_TARGET && rel >= 0) insn->operand[rel] = DASM_OPND_REL;
+}
+
+// For decoders that read ahead of what they know they need: past remaining
+// they read pad, the bytes that are left and zeros up to len.
+
+const uint8_t* dasm_pad(uint8_t* pad, int len, const uint8_t* data, uint64_t remaining)
+{
+    if (remaining >= (uint64_t) len) return data;
+    memset(pad, 0, len);
+    memcpy(pad, data, remaining);
+    return pad;
+}
+
+// Line for an instruction of len bytes of which only remaining are there:
+// those bytes as .byte, or (bad) when there are none. Returns how many it
+// covers, at least one so a walk always moves.
+
+int dasm_truncated(const uint8_t* data, uint64_t remaining, int len, char* text, struct dasm_insn* insn)
+{
+    int n = remaining < (uint64_t) len ? (int) remaining : len;
+    if (n == 0) strcpy(text, "(bad)");
+    else {
+        int at = sprintf(text, ".byte 0x%02x", data[0]);
+        for (int i = 1; i < n; i++) at += sprintf(text + at, ", 0x%02x", data[i]);
+    }
+    if (insn) {
+        dasm_insn_text(insn, text, DASM_FLOW_NEXT, DASM_NO_TARGET);
+        insn->length = n ? n : 1;
+    }
+    return n ? n : 1;
+}
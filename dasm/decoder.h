@@ -0,0 +1,79 @@
+#ifndef XT_DASM_DECODER_H
+#define XT_DASM_DECODER_H
+
+#include <stdint.h>
+
+#define DASM_TEXT_MAX 4096   // bytes a decoder may write to text
+#define DASM_OPERANDS 4
+#define DASM_NO_TARGET UINT64_MAX
+
+// What a decoder needs besides the bytes. The caller owns it, one per
+// thread; decoders read nothing else and keep nothing between calls, so
+// any number of them can run at once.
+
+struct dasm_ctx {
+    int arch;
+    int seg_size;
+    uint64_t end;    // file offset one past the last byte
+};
+
+enum dasm_flow {
+    DASM_FLOW_NEXT,      // falls through
+    DASM_FLOW_BRANCH,    // conditional: target or next
+    DASM_FLOW_JUMP,
+    DASM_FLOW_CALL,
+    DASM_FLOW_RET,
+};
+
+enum dasm_operand {
+    DASM_OPND_NONE,
+    DASM_OPND_REG,
+    DASM_OPND_IMM,
+    DASM_OPND_MEM,
+    DASM_OPND_REL,       // code address: the branch target
+};
+
+// What an instruction does, so analysis need not parse text. Targets are
+// file offsets as the decoder computed them; indirect transfers have none.
+
+struct dasm_insn {
+    uint64_t target;
+    uint16_t mnemonic;   // dasm_mnemonic_id, shared by all decoders
+    uint8_t length;
+    uint8_t flow;
+    uint8_t operands;
+    uint8_t operand[DASM_OPERANDS];
+};
+
+struct be_decoder {
+    const char* name;
+    void (*init)(void);
+    // Decodes the instruction at data, found at file offset offset, into
+    // text (DASM_TEXT_MAX bytes) and, when not NULL, insn. Reads no more
+    // than remaining bytes; an instruction cut short there comes out as
+    // .byte. Returns its length, never 0.
+    int (*decode_one)(const struct dasm_ctx* ctx, const uint8_t* data, uint64_t remaining,
+                      uint64_t offset, char* text, struct dasm_insn* insn);
+    // Decodes back to back from data[0, size) while a whole instruction
+    // fits, or to size when it ends the file, at most max of them, into
+    // length and, when not NULL, insn; returns how many.
+    int (*decode_batch)(const struct be_decoder* d, const struct dasm_ctx* ctx,
+                        const uint8_t* data, uint64_t size, uint64_t offset,
+                        struct dasm_insn* insn, uint8_t* length, int max);
+    int max_insn_len;
+    int alignment;
+};
+
+const struct be_decoder* be_decoder(int arch, int seg_size);
+void be_decoder_init();
+
+int dasm_decode_batch(const struct be_decoder* d, const struct dasm_ctx* ctx,
+                      const uint8_t* data, uint64_t size, uint64_t offset,
+                      struct dasm_insn* insn, uint8_t* length, int max);
+uint16_t dasm_mnemonic_id(const char* name, int len);
+const char* dasm_mnemonic(uint16_t id);
+void dasm_insn_text(struct dasm_insn* insn, const char* text, int flow, uint64_t target);
+const uint8_t* dasm_pad(uint8_t* pad, int len, const uint8_t* data, uint64_t remaining);
+int dasm_truncated(const uint8_t* data, uint64_t remaining, int len, char* text, struct dasm_insn* insn);
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef XT_DASM_DECODERS_H
+#define XT_DASM_DECODERS_H
+
+#include "decoder.h"
+
+// Every arch's be_decoder, so the registry need not see arch internals.
+
+extern const struct be_decoder be_decoder_x86;
+extern const struct be_decoder be_decoder_arm64;
+extern const struct be_decoder be_decoder_arm32;
+extern const struct be_decoder be_decoder_riscv;
+extern const struct be_decoder be_decoder_ppc;
+extern const struct be_decoder be_decoder_mips;
+extern const struct be_decoder be_decoder_m68k;
+extern const struct be_decoder be_decoder_sh4;
+extern const struct be_decoder be_decoder_pdp11;
+extern const struct be_decoder be_decoder_nv;
+
+#endif
@@ -0,0 +1,143 @@
+// BE: INFOSEC BINARY HEX EDITOR WITH DASM
+// Synrc Research (c) 2022-2025
+// 5HT DHARMA License
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cache.h"
+#include "dasm.h"
+#include "decoder.h"
+#include "index.h"
+
+#define NONE UINT64_MAX
+#define SWEEP_BATCH 256
+
+static struct {
+    uint64_t* marks;   // marks[k]: first boundary at or after k * DASM_CHECKPOINT
+    size_t count;
+    enum dasm_arch arch;
+    int seg_size;
+} idx;
+
+static void index_prepare(struct editor* e) {
+    size_t count = e->content_length / DASM_CHECKPOINT + 1;
+    if (idx.arch != e->arch || idx.seg_size != e->seg_size) {
+        for (size_t k = 0; k < idx.count; k++) idx.marks[k] = NONE;
+        idx.arch = e->arch;
+        idx.seg_size = e->seg_size;
+    }
+    if (count == idx.count) return;
+    idx.marks = realloc(idx.marks, count * sizeof(uint64_t));
+    if (idx.marks == NULL) { perror("Unable to grow instruction index"); exit(1); }
+    for (size_t k = idx.count; k < count; k++) idx.marks[k] = NONE;
+    idx.count = count;
+}
+
+// First boundary at or after to, decoding from the boundary from. Only
+// lengths are needed, so it runs the decoder's batch entry over a span
+// without describing instructions, and leaves the line cache to what is
+// on screen. With ring, the boundaries before to go round it, n slots,
+// and count says how many did.
+
+static uint64_t walk(struct editor* e, uint64_t from, uint64_t to, uint64_t* ring, int n, size_t* count) {
+    const struct be_decoder* d = be_decoder(e->arch, e->seg_size);
+    struct dasm_ctx ctx = { e->arch, e->seg_size, e->content_length };
+    uint8_t length[SWEEP_BATCH];
+    char span[DASM_CHECKPOINT + DASM_CACHE_REACH];
+    if (to > e->content_length) to = e->content_length;
+    if (d == NULL) {
+        for (; ring != NULL && from < to; from++) ring[(*count)++ % n] = from;
+        return from < to ? to : from;
+    }
+    while (from < to) {
+        uint64_t size = to - from + d->max_insn_len - 1;
+        if (size > sizeof(span)) size = sizeof(span);
+        if (size > ctx.end - from) size = ctx.end - from;
+        const char* q = editor_span(e, from, size, span);
+        int got = d->decode_batch(d, &ctx, (const uint8_t*) q, size, from, NULL, length, SWEEP_BATCH);
+        for (int i = 0; i < got && from < to; i++) {
+            if (ring != NULL) ring[(*count)++ % n] = from;
+            from += length[i];
+        }
+    }
+    return from;
+}
+
+static uint64_t sweep(struct editor* e, uint64_t from, uint64_t to) {
+    return walk(e, from, to, NULL, 0, NULL);
+}
+
+static uint64_t resync(struct editor* e, uint64_t to) {
+    uint64_t lands[DASM_RESYNC_TRIES];
+    int best = 0, votes = 0;
+    for (int t = 0; t < DASM_RESYNC_TRIES; t++) {
+        lands[t] = sweep(e, to - DASM_RESYNC + t, to);
+        int n = 0;
+        for (int u = 0; u <= t; u++) n += lands[u] == lands[t];
+        if (n > votes) { best = t; votes = n; }
+    }
+    return lands[best];
+}
+
+static uint64_t index_mark(struct editor* e, size_t k) {
+    if (idx.marks[k] != NONE) return idx.marks[k];
+    size_t j = k;
+    while (j > 0 && k - j < DASM_SWEEP_REGIONS && idx.marks[j - 1] == NONE) j--;
+    uint64_t at = (uint64_t) j * DASM_CHECKPOINT, m;
+    if (j == 0) m = 0;
+    else if (idx.marks[j - 1] != NONE) m = sweep(e, idx.marks[j - 1], at);
+    else m = at < DASM_RESYNC ? sweep(e, 0, at) : resync(e, at);
+    idx.marks[j] = m;
+    for (; j < k; j++) idx.marks[j + 1] = m = sweep(e, m, (uint64_t) (j + 1) * DASM_CHECKPOINT);
+    return m;
+}
+
+// Start of the n-th instruction before offset in the indexed stream, or the
+// first one of the file when there are fewer. With n = 1 and offset + 1 it
+// is the instruction holding offset.
+
+uint64_t dasm_back(struct editor* e, uint64_t offset, int n) {
+    static uint64_t ring[DASM_BACK_MAX];
+    if (n <= 0 || offset == 0) return offset;
+    if (n > DASM_BACK_MAX) n = DASM_BACK_MAX;
+    index_prepare(e);
+    if (offset > e->content_length) offset = e->content_length;
+
+    size_t k = offset / DASM_CHECKPOINT;
+    if (k >= idx.count) k = idx.count - 1;
+    while (true) {
+        while (k > 0 && index_mark(e, k) >= offset) k--;
+        uint64_t from = index_mark(e, k);
+        size_t count = 0;
+        walk(e, from, offset, ring, n, &count);
+        if (count >= (size_t) n) return ring[count % n];
+        if (k == 0) return count ? ring[0] : offset;
+        k--;
+    }
+}
+
+// Start of the n-th instruction after offset, stopping at the last one.
+
+uint64_t dasm_forward(struct editor* e, uint64_t offset, int n) {
+    for (int i = 0; i < n; i++) {
+        uint64_t next = offset + dasm_length(e, offset);
+        if (next >= e->content_length) break;
+        offset = next;
+    }
+    return offset;
+}
+
+// A replace only disturbs the regions it touches; later checkpoints are
+// kept, since streams fall back into step after a few instructions (and
+// fixed-width ones never leave it). Inserts and deletes pass end = MAX and
+// drop everything after start.
+
+void dasm_index_invalidate(uint64_t start, uint64_t end) {
+    if (idx.count == 0 || start >= end) return;
+    uint64_t from = start > DASM_CACHE_REACH - 1 ? start - (DASM_CACHE_REACH - 1) : 0;
+    size_t k = from / DASM_CHECKPOINT + 1;
+    size_t last = end == UINT64_MAX ? idx.count : end / DASM_CHECKPOINT + 2;
+    for (; k < last && k < idx.count; k++) idx.marks[k] = NONE;
+}
@@ -0,0 +1,26 @@
+#ifndef XT_DASM_INDEX_H
+#define XT_DASM_INDEX_H
+
+#include <stdint.h>
+
+#include "../editor.h"
+
+#define DASM_CHECKPOINT 1024      // bytes per checkpoint region
+#define DASM_SWEEP_REGIONS 64     // farthest a sweep walks to fill a checkpoint
+#define DASM_RESYNC 256           // bytes decoded ahead of a cold checkpoint
+#define DASM_RESYNC_TRIES 8
+#define DASM_BACK_MAX 1024
+
+// Instruction boundary index for the ASM view. The file is cut into
+// DASM_CHECKPOINT regions and each region gets, lazily, the first boundary
+// at or after its start: swept from the previous checkpoint when one is
+// near, otherwise resynchronised by decoding from a little earlier at a few
+// alignments and taking the boundary most of them agree on, which is how
+// x86 streams fall back into step. Walking back n instructions then costs
+// at most a region or two of (cached) decoding, wherever the view is.
+
+uint64_t dasm_back(struct editor* e, uint64_t offset, int n);
+uint64_t dasm_forward(struct editor* e, uint64_t offset, int n);
+void dasm_index_invalidate(uint64_t start, uint64_t end);
+
+#endif
@@ -5,10 +5,14 @@
 #include <assert.h>
 #include <ctype.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
 #include <stdarg.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <sys/ioctl.h>
@@ -16,11 +20,14 @@
 
 #include "dasm/dasm.h"
 #include "hex/hex.h"
+#include "hex/patch.h"
+#include "search/multi.h"
+#include "search/search.h"
+#include "search/worker.h"
+#include "term/screen.h"
 #include "term/terminal.h"
 #include "editor.h"
 
-char* contents;
-int content_length = 0;
 static struct editor* e;
 
 struct editor* editor() {
@@ -37,7 +44,19 @@ struct editor* editor_init() {
     e->filename = NULL;
     e->contents = NULL;
     e->content_length = 0;
+    e->mapping_size = 0;
+    piece_init(&e->pieces, NULL, 0);
+    undo_init(&e->undo, UNDO_LIMIT);
     e->dirty = false;
+    e->resized = false;
+    e->dirty_ranges = NULL;
+    e->dirty_count = 0;
+    e->dirty_cap = 0;
+    e->search = NULL;
+    e->frame = charbuf_create();
+    e->hits = NULL;
+    e->hit_count = e->hit_cap = e->hit_pos = 0;
+    e->frame_rate = FRAME_RATE;
     e->offset_dasm = 0;
     e->mode = MODE_NORMAL;
     e->view = VIEW_HEX;
@@ -46,53 +65,105 @@ struct editor* editor_init() {
     memset(e->status_message, '\0', sizeof(e->status_message));
     memset(e->inputbuffer, '\0', sizeof(e->inputbuffer));
     memset(e->searchstr, '\0', sizeof(e->searchstr));
+    e->screen_rows = 24;
+    e->screen_cols = 80;
     get_window_size(&(e->screen_rows), &(e->screen_cols));
     return e;
 }
 
-int editor_parse_search_string(const char* inputstr, struct charbuf* parsedstr, const char** err_info)
+// One hex digit or '?' (any nibble) into value/mask bits at shift.
+
+static bool parse_nibble(char c, int shift, unsigned char* value, unsigned char* mask) {
+    if (c == '?') return true;
+    if (!isxdigit((unsigned char) c)) return false;
+    *value |= (isdigit((unsigned char) c) ? c - '0' : (tolower((unsigned char) c) - 'a' + 10)) << shift;
+    *mask |= 0xF << shift;
+    return true;
+}
+
+// "[n]" or "[n-m]"; s points past '['.
+
+static bool parse_gap(const char** s, struct search_pattern* p) {
+    char* end;
+    unsigned long min = strtoul(*s, &end, 10), max = min;
+    if (end == *s) return false;
+    if (*end == '-') {
+        const char* from = end + 1;
+        max = strtoul(from, &end, 10);
+        if (end == from) return false;
+    }
+    if (*end != ']') return false;
+    *s = end + 1;
+    return search_add_gap(p, min, max);
+}
+
+static int parse_byte(const char** s, struct search_pattern* p) {
+    unsigned char value = 0, mask = 0;
+    if ((*s)[0] == '\0' || (*s)[1] == '\0') return PARSE_INCOMPLETE_HEX;
+    if (!parse_nibble((*s)[0], 4, &value, &mask) || !parse_nibble((*s)[1], 0, &value, &mask)) return PARSE_INVALID_HEX;
+    search_add_byte(p, value, mask);
+    *s += 2;
+    return PARSE_SUCCESS;
+}
+
+// YARA style hex string: "{48 8B ?? ?4 E8 [2-4] C3}".
+
+static bool editor_parse_hex_pattern(const char* s, struct search_pattern* p) {
+    if (*s++ != '{') return false;
+    while (*s != '}') {
+        if (*s == ' ') { s++; continue; }
+        if (*s == '[') { s++; if (!parse_gap(&s, p)) return false; continue; }
+        if (parse_byte(&s, p) != PARSE_SUCCESS) return false;
+    }
+    return s[1] == '\0' && p->count > 0 && p->segments[p->segcount - 1].len > 0;
+}
+
+// Escaped string: "\\", "\xNN" where either digit may be '?', "\?" for any
+// byte and "\[n]" or "\[n-m]" for a gap of wildcards.
+
+int editor_parse_search_string(const char* inputstr, struct search_pattern* p, const char** err_info)
 {
-    char hex[3] = {'\0'};
     *err_info = inputstr;
     while (*inputstr != '\0') {
         if (*inputstr == '\\') {
             ++inputstr;
+            *err_info = inputstr;
             switch (*(inputstr)) {
                 case '\0': return PARSE_INCOMPLETE_BACKSLASH;
-                case '\\': charbuf_append(parsedstr, "\\", 1); ++inputstr; break;
+                case '\\': search_add_byte(p, '\\', 0xFF); ++inputstr; break;
+                case '?': search_add_byte(p, 0, 0); ++inputstr; break;
+                case '[': ++inputstr;
+                          if (!parse_gap(&inputstr, p)) return PARSE_INVALID_GAP;
+                          break;
                 case 'x': ++inputstr;
-                          int off = 0;
-                          if (*inputstr == '\0' || *(inputstr + 1) == '\0') return PARSE_INCOMPLETE_HEX;
-//                          while (*inputstr != '\0' && isxdigit(*inputstr + off)) {
-  //                            off++;
-    //                      }
-//                          printf("OK\n");
-//                          if (off < 2) {
-                          if (!isxdigit(*inputstr) || !isxdigit(*(inputstr + 1))) {
-                              *err_info = inputstr;
-                              return PARSE_INVALID_HEX;
-                          }
-                          memcpy(hex, inputstr, 2);
-                          char bin = hex2bin(hex);
-                          charbuf_append(parsedstr, &bin, 1);
-                          inputstr += 2;
+                          *err_info = inputstr;
+                          int err = parse_byte(&inputstr, p);
+                          if (err != PARSE_SUCCESS) return err;
                           break;
-                default: *err_info = inputstr; return PARSE_INVALID_ESCAPE;
+                default: return PARSE_INVALID_ESCAPE;
             }
         } else {
-            charbuf_append(parsedstr, inputstr, 1);
+            search_add_byte(p, *inputstr, 0xFF);
             ++inputstr;
         }
     }
+    if (p->count > 0 && p->segments[p->segcount - 1].len == 0) return PARSE_INVALID_GAP;
     return PARSE_SUCCESS;
 }
 
+// Either syntax into an initialized pattern, released again on error.
+
+static int editor_parse_pattern(const char* str, struct search_pattern* p, const char** err_info) {
+    search_init(p);
+    if (editor_parse_hex_pattern(str, p)) return PARSE_SUCCESS;
+    search_release(p);
+    return editor_parse_search_string(str, p, err_info);
+}
+
 void editor_process_search(struct editor* e, const char* str, enum search_direction dir) {
-    struct charbuf *parsedstr = NULL;
     const char* parse_err;
-    int parse_errno = 0;
+    int parse_errno = PARSE_SUCCESS;
 
-    parsedstr = charbuf_create();
     if (strncmp(str, "", INPUT_BUF_SIZE) == 0) {
         strncpy(e->searchstr, str, INPUT_BUF_SIZE);
         return;
@@ -100,12 +171,8 @@ void editor_process_search(struct editor* e, const char* str, enum search_direct
 
     if (strncmp(str, e->searchstr, INPUT_BUF_SIZE) != 0) strncpy(e->searchstr, str, INPUT_BUF_SIZE);
 
-    if (dir == SEARCH_BACKWARD && editor_offset_at_cursor(e) == 0) {
-        editor_statusmessage(e, STATUS_INFO, "Already at start of the file");
-        return;
-    }
-
-    parse_errno = editor_parse_search_string(str, parsedstr, &parse_err);
+    struct search_pattern pattern;
+    parse_errno = editor_parse_pattern(str, &pattern, &parse_err);
     switch (parse_errno) {
         case PARSE_INCOMPLETE_BACKSLASH:
              editor_statusmessage(e, STATUS_ERROR, "Nothing follows '\\' in search string: %s", str); break;
@@ -115,49 +182,413 @@ void editor_process_search(struct editor* e, const char* str, enum search_direct
              editor_statusmessage(e, STATUS_ERROR, "Invalid hex value (\\x%c%c) in search string: %s", *parse_err, *(parse_err + 1), str); break;
         case PARSE_INVALID_ESCAPE:
              editor_statusmessage(e, STATUS_ERROR, "Invalid character after \\ (%c) in search string: %s", *parse_err, str); break;
+        case PARSE_INVALID_GAP:
+             editor_statusmessage(e, STATUS_ERROR, "Invalid gap at %s in search string: %s", parse_err, str); break;
         case PARSE_SUCCESS: break;
     }
 
-    if (parse_errno != PARSE_SUCCESS) {
-        charbuf_free(parsedstr);
+    if (parse_errno != PARSE_SUCCESS) return;
+    if (!search_compile(&pattern)) {
+        search_release(&pattern);
+        editor_statusmessage(e, STATUS_WARNING, "String not found: '%s'", str);
         return;
     }
 
-    unsigned int current_offset = editor_offset_at_cursor(e);
-    bool found = false;
-    if (dir == SEARCH_FORWARD) {
-        current_offset++;
-        for (; current_offset < e->content_length; current_offset++) {
-            if (memcmp(e->contents + current_offset, parsedstr->contents, parsedstr->len) == 0) {
-                editor_statusmessage(e, STATUS_INFO, "");
-                editor_scroll_to_offset(e, current_offset);
-                found = true;
-                break;
-            }
+    uint64_t current_offset = editor_offset_at_cursor(e);
+    editor_search_cancel(e);
+    e->search = search_job_start(e, &pattern, dir, dir == SEARCH_FORWARD ? current_offset + 1 : current_offset);
+    editor_statusmessage(e, STATUS_INFO, "Searching '%s'...", str);
+}
+
+// Called from the main loop: jumps to the first match once the worker has
+// seen it, keeps the status line up to date and reaps the finished job.
+
+void editor_search_poll(struct editor* e) {
+    if (e->search == NULL) return;
+    struct search_progress p;
+    search_job_progress(e->search, &p);
+
+    if (p.found && !e->search->shown) {
+        e->search->shown = true;
+        editor_scroll_to_offset(e, p.first);
+    }
+
+    if (p.running) {
+        editor_statusmessage(e, STATUS_INFO, "Searching '%s': %d%%, %" PRIu64 " matches (ESC to cancel)",
+            e->searchstr, p.total ? (int) (p.done * 100 / p.total) : 100, p.hits);
+        return;
+    }
+
+    search_job_finish(e->search, false);
+    e->search = NULL;
+    if (p.found) editor_statusmessage(e, STATUS_INFO, "Match at 0x%09" PRIx64 ", %" PRIu64 " matches in file", p.first, p.hits);
+    else editor_statusmessage(e, STATUS_WARNING, "String not found: '%s'", e->searchstr);
+}
+
+// Stops a running search; required before anything modifies the buffer.
+
+bool editor_search_cancel(struct editor* e) {
+    if (e->search == NULL) return false;
+    search_job_finish(e->search, true);
+    e->search = NULL;
+    return true;
+}
+
+static void editor_show_hit(struct editor* e, size_t pos) {
+    e->hit_pos = pos;
+    editor_scroll_to_offset(e, e->hits[pos].offset);
+    editor_statusmessage(e, STATUS_INFO, "Hit %zu/%zu at 0x%09" PRIx64 ": pattern on line %u",
+        pos + 1, e->hit_count, e->hits[pos].offset, e->hits[pos].pattern);
+}
+
+// Moves to the next (or previous) entry of the :findall hit list relative
+// to the cursor; several patterns hitting one offset are visited in turn.
+
+void editor_next_hit(struct editor* e, enum search_direction dir) {
+    uint64_t offset = editor_offset_at_cursor(e);
+    size_t pos;
+    if (e->hit_pos < e->hit_count && e->hits[e->hit_pos].offset == offset) {
+        if (dir == SEARCH_FORWARD ? e->hit_pos + 1 >= e->hit_count : e->hit_pos == 0) {
+            editor_statusmessage(e, STATUS_WARNING, "No more hits (%zu total)", e->hit_count);
+            return;
         }
-    } else if (dir == SEARCH_BACKWARD) {
-        current_offset--;
-        for (; current_offset-- != 0; ) {
-            if (memcmp(e->contents + current_offset, parsedstr->contents, parsedstr->len) == 0) {
-                editor_statusmessage(e, STATUS_INFO, "");
-                editor_scroll_to_offset(e, current_offset);
-                found = true;
-                break;
-            }
-       }
+        pos = dir == SEARCH_FORWARD ? e->hit_pos + 1 : e->hit_pos - 1;
+    } else {
+        size_t lo = 0, hi = e->hit_count;
+        while (lo < hi) {
+            size_t mid = lo + (hi - lo) / 2;
+            if (dir == SEARCH_FORWARD ? e->hits[mid].offset <= offset : e->hits[mid].offset < offset) lo = mid + 1; else hi = mid;
+        }
+        if (dir == SEARCH_FORWARD ? lo == e->hit_count : lo == 0) {
+            editor_statusmessage(e, STATUS_WARNING, "No more hits (%zu total)", e->hit_count);
+            return;
+        }
+        pos = dir == SEARCH_FORWARD ? lo : lo - 1;
+    }
+    editor_show_hit(e, pos);
+}
+
+// One pattern per line in the / syntax; empty lines and lines starting
+// with '#' are skipped. All patterns are matched in a single pass.
+
+void editor_findall(struct editor* e, const char* path) {
+    editor_search_cancel(e);
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+        editor_statusmessage(e, STATUS_ERROR, "Unable to open %s: %s", path, strerror(errno));
+        return;
+    }
+
+    struct search_set set;
+    search_set_init(&set);
+    char* line = NULL;
+    size_t cap = 0;
+    uint32_t lineno = 0;
+    bool ok = true;
+    while (ok && getline(&line, &cap, fp) != -1) {
+        lineno++;
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '\0' || line[0] == '#') continue;
+
+        struct search_pattern pattern;
+        const char* parse_err;
+        if (editor_parse_pattern(line, &pattern, &parse_err) != PARSE_SUCCESS) {
+            editor_statusmessage(e, STATUS_ERROR, "%s:%u: invalid pattern: %s", path, lineno, line);
+            ok = false;
+        } else if (!search_compile(&pattern) || !search_set_add(&set, &pattern, lineno)) {
+            editor_statusmessage(e, STATUS_ERROR, "%s:%u: pattern has no literal byte: %s", path, lineno, line);
+            search_release(&pattern);
+            ok = false;
+        }
+    }
+    free(line);
+    fclose(fp);
+
+    if (ok && set.count == 0) {
+        editor_statusmessage(e, STATUS_ERROR, "No patterns in %s", path);
+        ok = false;
+    }
+    if (!ok) {
+        search_set_release(&set);
+        return;
+    }
+
+    search_set_build(&set);
+    bool complete = search_set_scan(e, &set);
+    size_t patterns = set.count;
+    search_set_release(&set);
+
+    if (e->hit_count == 0) {
+        editor_statusmessage(e, STATUS_WARNING, "No hits for %zu patterns", patterns);
+        return;
+    }
+    uint64_t offset = editor_offset_at_cursor(e);
+    size_t pos = 0;
+    while (pos + 1 < e->hit_count && e->hits[pos].offset < offset) pos++;
+    editor_show_hit(e, pos);
+    size_t len = strlen(e->status_message);
+    snprintf(e->status_message + len, sizeof(e->status_message) - len, " (%zu patterns%s)", patterns, complete ? "" : ", list truncated");
+}
+
+// Site that would grow the file past reason: starting more than
+// PATCH_GAP_MAX past the end as the sites before it leave it, or running
+// past 2^64. NULL when every site fits.
+
+static const struct patch_site* patch_misfit(const struct patch* p, uint64_t length) {
+    for (size_t i = 0; i < p->count; i++) {
+        const struct patch_site* s = &p->sites[i];
+        if (s->offset > length && s->offset - length > PATCH_GAP_MAX) return s;
+        if (s->offset + s->length < s->offset) return s;
+        if (s->offset + s->length > length) length = s->offset + s->length;
+    }
+    return NULL;
+}
+
+// Applies every site of an IPS file or "offset: hexbytes" listing as one
+// undo step. Sites past the end of the file extend it.
+
+void editor_patch(struct editor* e, const char* path) {
+    struct patch p;
+    patch_init(&p);
+    if (!patch_load(&p, path)) {
+        if (p.line) editor_statusmessage(e, STATUS_ERROR, "%s:%u: %s", path, p.line, p.error);
+        else editor_statusmessage(e, STATUS_ERROR, "Unable to apply %s: %s", path, p.error);
+        patch_free(&p);
+        return;
+    }
+    const struct patch_site* misfit = patch_misfit(&p, e->content_length);
+    if (misfit != NULL) {
+        editor_statusmessage(e, STATUS_ERROR, "Unable to apply %s: site at 0x%" PRIx64 " is too far past the end", path, misfit->offset);
+        patch_free(&p);
+        return;
     }
 
-    charbuf_free(parsedstr);
-    if (!found) editor_statusmessage(e, STATUS_WARNING, "String not found: '%s'", str);
+    editor_search_cancel(e);
+    undo_begin(&e->undo);
+    for (size_t i = 0; i < p.count; i++) {
+        const struct patch_site* s = &p.sites[i];
+        const char* data = p.data + s->at;
+        while (s->offset > e->content_length) {
+            static const char zeros[4096];
+            uint64_t n = s->offset - e->content_length;
+            editor_insert_bytes(e, e->content_length, zeros, n < sizeof(zeros) ? n : sizeof(zeros));
+        }
+        uint64_t over = e->content_length - s->offset;
+        if (over > s->length) over = s->length;
+        if (over) editor_write_bytes(e, s->offset, data, over);
+        if (over < s->length) editor_insert_bytes(e, s->offset + over, data + over, s->length - over);
+    }
+    if (p.truncate && p.truncate_at < e->content_length)
+        editor_delete_bytes(e, p.truncate_at, e->content_length - p.truncate_at);
+    bool undoable = undo_end(&e->undo);
+
+    if (p.count && e->content_length) editor_scroll_to_offset(e, p.sites[0].offset < e->content_length ? p.sites[0].offset : e->content_length - 1);
+    if (undoable) editor_statusmessage(e, STATUS_INFO, "Patched %zu sites, %" PRIu64 " bytes from %s", p.count, p.len, path);
+    else editor_statusmessage(e, STATUS_WARNING, "Patched %zu sites, %" PRIu64 " bytes from %s; too large to undo", p.count, p.len, path);
+    patch_free(&p);
+}
+
+// Bracketed paste: the whole text arrives as one key and lands as one
+// edit, so a long hex string is one undo record and one repaint. Hex modes
+// take hex digits (whitespace ignored), ASCII modes the raw text.
+
+static void editor_paste(struct editor* e) {
+    size_t len;
+    const char* text = paste_text(&len);
+    memset(hexstr(), '\0', 3);
+    hexstr_idx_set(0);
+
+    if (e->mode & (MODE_COMMAND | MODE_SEARCH)) {
+        for (size_t i = 0; i < len && (size_t) e->inputbuffer_index < sizeof(e->inputbuffer) - 1; i++)
+            if (isprint((unsigned char) text[i])) e->inputbuffer[e->inputbuffer_index++] = text[i];
+        return;
+    }
+    if (!(e->mode & (MODE_INSERT | MODE_APPEND | MODE_REPLACE | MODE_INSERT_ASCII | MODE_APPEND_ASCII | MODE_REPLACE_ASCII))) {
+        editor_statusmessage(e, STATUS_WARNING, "Paste ignored: enter insert or replace mode first");
+        return;
+    }
+
+    char* bytes = NULL;
+    int64_t n = len;
+    if (e->mode & (MODE_INSERT | MODE_APPEND | MODE_REPLACE)) {
+        bytes = malloc(len / 2 + 1);
+        if (bytes == NULL) { perror("Unable to allocate paste"); exit(1); }
+        n = patch_hex(text, len, bytes);
+        if (n < 0) {
+            editor_statusmessage(e, STATUS_ERROR, "Paste is not a hex string");
+            free(bytes);
+            return;
+        }
+        text = bytes;
+    }
+    if (n == 0) {
+        free(bytes);
+        return;
+    }
+
+    uint64_t offset = editor_offset_at_cursor(e);
+    if (e->mode & (MODE_REPLACE | MODE_REPLACE_ASCII)) {
+        if (e->content_length == 0) {
+            editor_statusmessage(e, STATUS_ERROR, "File is empty, nothing to replace");
+            free(bytes);
+            return;
+        }
+        if ((uint64_t) n > e->content_length - offset) n = e->content_length - offset;
+        editor_write_bytes(e, offset, text, n);
+    } else {
+        if ((e->mode & (MODE_APPEND | MODE_APPEND_ASCII)) && e->content_length) offset++;
+        editor_insert_bytes(e, offset, text, n);
+    }
+    free(bytes);
+    undo_seal(&e->undo);
+
+    uint64_t next = offset + n;
+    if (next >= e->content_length) next = e->content_length ? e->content_length - 1 : 0;
+    editor_scroll_to_offset(e, next);
+    editor_statusmessage(e, STATUS_INFO, "Pasted %" PRId64 " bytes at offset %09" PRIx64, n, offset);
 }
 
 void editor_newfile(struct editor* e, const char* filename) {
     e->filename = malloc(strlen(filename) + 1);
     e->contents = malloc(0);
     e->content_length = 0;
+    piece_free(&e->pieces);
+    piece_init(&e->pieces, e->contents, 0);
+    e->resized = true;
     strncpy(e->filename, filename, strlen(filename) + 1);
 }
 
+// Private mapping: views read the page cache, replaced bytes go to COW pages.
+// A read-only zero pad follows EOF so decoders peeking past the end don't fault.
+
+static char* editor_map_file(int fd, size_t length, size_t* mapping_size) {
+    size_t page = sysconf(_SC_PAGESIZE);
+    size_t mapped = (length + page - 1) / page * page;
+    size_t reserve = mapped + EDITOR_MAP_PAD;
+
+    char* base = mmap(NULL, reserve, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) return NULL;
+
+    if (mmap(base, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED | MAP_NORESERVE, fd, 0) == MAP_FAILED
+     || mprotect(base + mapped, EDITOR_MAP_PAD, PROT_READ) != 0) {
+        munmap(base, reserve);
+        return NULL;
+    }
+
+    *mapping_size = reserve;
+    return base;
+}
+
+// Dirty ranges are kept sorted and disjoint; touching ranges are merged.
+
+static void editor_mark_dirty(struct editor* e, uint64_t start, uint64_t end) {
+    dasm_invalidate(start, end);
+    size_t lo = 0, hi = e->dirty_count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (e->dirty_ranges[mid].end < start) lo = mid + 1; else hi = mid;
+    }
+
+    size_t i = lo, j = lo;
+    while (j < e->dirty_count && e->dirty_ranges[j].start <= end) {
+        if (e->dirty_ranges[j].start < start) start = e->dirty_ranges[j].start;
+        if (e->dirty_ranges[j].end > end) end = e->dirty_ranges[j].end;
+        j++;
+    }
+
+    if (i == j) {
+        if (e->dirty_count == e->dirty_cap) {
+            e->dirty_cap = e->dirty_cap ? e->dirty_cap * 2 : 64;
+            e->dirty_ranges = realloc(e->dirty_ranges, e->dirty_cap * sizeof(struct dirty_range));
+            if (e->dirty_ranges == NULL) { perror("Unable to grow dirty ranges"); exit(1); }
+        }
+        memmove(&e->dirty_ranges[i + 1], &e->dirty_ranges[i], (e->dirty_count - i) * sizeof(struct dirty_range));
+        e->dirty_count++;
+    } else if (j > i + 1) {
+        memmove(&e->dirty_ranges[i + 1], &e->dirty_ranges[j], (e->dirty_count - j) * sizeof(struct dirty_range));
+        e->dirty_count -= j - i - 1;
+    }
+    e->dirty_ranges[i] = (struct dirty_range) { start, end };
+    e->dirty = true;
+}
+
+unsigned char editor_byte_at(struct editor* e, uint64_t offset) {
+    uint64_t run;
+    if (offset >= e->content_length) return 0;
+    return *piece_at(&e->pieces, offset, &run);
+}
+
+const char* editor_span(struct editor* e, uint64_t offset, uint64_t length, char* scratch) {
+    return piece_span(&e->pieces, offset, length, scratch);
+}
+
+void editor_write_bytes(struct editor* e, uint64_t offset, const char* data, uint64_t length) {
+    char *old, *new;
+    editor_search_cancel(e);
+    if (offset >= e->content_length) return;
+    if (length > e->content_length - offset) length = e->content_length - offset;
+    if (undo_push(&e->undo, UNDO_REPLACE, offset, length, &old, &new)) {
+        piece_read(&e->pieces, offset, old, length);
+        memcpy(new, data, length);
+    }
+    piece_write(&e->pieces, offset, data, length);
+    editor_mark_dirty(e, offset, offset + length);
+}
+
+void editor_insert_bytes(struct editor* e, uint64_t offset, const char* data, uint64_t length) {
+    char *old, *new;
+    editor_search_cancel(e);
+    if (undo_push(&e->undo, UNDO_INSERT, offset, length, &old, &new)) memcpy(new, data, length);
+    piece_insert(&e->pieces, offset, data, length);
+    dasm_invalidate(offset, UINT64_MAX);
+    e->content_length = e->pieces.length;
+    e->resized = true;
+    e->dirty = true;
+}
+
+void editor_delete_bytes(struct editor* e, uint64_t offset, uint64_t length) {
+    char *old, *new;
+    editor_search_cancel(e);
+    if (offset >= e->content_length) return;
+    if (length > e->content_length - offset) length = e->content_length - offset;
+    if (undo_push(&e->undo, UNDO_DELETE, offset, length, &old, &new)) piece_read(&e->pieces, offset, old, length);
+    piece_erase(&e->pieces, offset, length);
+    dasm_invalidate(offset, UINT64_MAX);
+    e->content_length = e->pieces.length;
+    e->resized = true;
+    e->dirty = true;
+}
+
+void editor_undo(struct editor* e, bool redo) {
+    editor_search_cancel(e);
+    size_t n = undo_count(&e->undo, redo);
+    if (n == 0) {
+        editor_statusmessage(e, STATUS_INFO, redo ? "Already at newest change" : "Already at oldest change");
+        return;
+    }
+
+    uint64_t offset = 0, bytes = 0;
+    for (size_t i = 0; i < n; i++) {
+        struct undo_record* r = redo ? undo_forward(&e->undo) : undo_back(&e->undo);
+        const char* data = redo ? undo_new(&e->undo, r) : undo_old(&e->undo, r);
+        if (r->kind == UNDO_REPLACE) piece_write(&e->pieces, r->offset, data, r->length);
+        else if ((r->kind == UNDO_INSERT) == redo) piece_insert(&e->pieces, r->offset, data, r->length);
+        else piece_erase(&e->pieces, r->offset, r->length);
+        if (r->kind == UNDO_REPLACE) editor_mark_dirty(e, r->offset, r->offset + r->length);
+        else {
+            dasm_invalidate(r->offset, UINT64_MAX);
+            e->resized = true;
+        }
+        offset = r->offset;
+        bytes += r->length;
+    }
+
+    e->content_length = e->pieces.length;
+    e->dirty = true;
+    if (e->content_length) editor_scroll_to_offset(e, offset < e->content_length ? offset : e->content_length - 1);
+    editor_statusmessage(e, STATUS_INFO, "%s %" PRIu64 " bytes at offset %09" PRIx64, redo ? "Redo:" : "Undo:", bytes, offset);
+}
+
 void editor_openfile(struct editor* e, const char* filename) {
     FILE* fp = fopen(filename, "rb");
     if (fp == NULL) {
@@ -170,7 +601,7 @@ void editor_openfile(struct editor* e, const char* filename) {
     }
 
     struct stat statbuf;
-    if (stat(filename, &statbuf) == -1) {
+    if (fstat(fileno(fp), &statbuf) == -1) {
         perror("Cannot stat file");
         exit(1);
     }
@@ -180,6 +611,8 @@ void editor_openfile(struct editor* e, const char* filename) {
         exit(1);
     }
 
+    char* contents = NULL;
+    size_t mapping_size = 0;
 
     if (statbuf.st_size <= 0) {
         struct charbuf* buf = charbuf_create();
@@ -187,25 +620,30 @@ void editor_openfile(struct editor* e, const char* filename) {
         char tempbuf[1];
         while ((c = fgetc(fp)) != EOF) { tempbuf[0] = (char) c; charbuf_append(buf, tempbuf, 1); }
         contents = buf->contents;
-        content_length = buf->len;
+        e->content_length = buf->len;
+        free(buf);
     } else {
-        contents = malloc(sizeof(char) * statbuf.st_size);
-        content_length = statbuf.st_size;
-
-        if (fread(contents, 1, statbuf.st_size, fp) < (size_t) statbuf.st_size) {
-            perror("Unable to read file contents");
-            free(contents);
-            exit(1);
+        contents = editor_map_file(fileno(fp), statbuf.st_size, &mapping_size);
+        e->content_length = statbuf.st_size;
+        if (contents == NULL) {
+            contents = malloc(sizeof(char) * statbuf.st_size);
+            if (contents == NULL || fread(contents, 1, statbuf.st_size, fp) < (size_t) statbuf.st_size) {
+                perror("Unable to read file contents");
+                free(contents);
+                exit(1);
+            }
         }
     }
 
     e->filename = malloc(strlen(filename) + 1);
     strncpy(e->filename, filename, strlen(filename) + 1);
     e->contents = contents;
-    e->content_length = content_length;
+    e->mapping_size = mapping_size;
+    piece_free(&e->pieces);
+    piece_init(&e->pieces, contents, e->content_length);
 
     if (access(filename, W_OK) == -1) {
-        editor_statusmessage(e, STATUS_WARNING, "\"%s\" (%d bytes) [readonly]", e->filename, e->content_length);
+        editor_statusmessage(e, STATUS_WARNING, "\"%s\" (%" PRIu64 " bytes) [readonly]", e->filename, e->content_length);
     } else {
 //		editor_statusmessage(e, STATUS_INFO, "\"%s\" (%d bytes)", e->filename, e->content_length);
 //		editor_statusmessage(e, STATUS_INFO, "Terminal: %ix%i.", e->screen_cols, e->screen_rows);
@@ -215,25 +653,104 @@ void editor_openfile(struct editor* e, const char* filename) {
     fclose(fp);
 }
 
+static bool editor_write_range(struct editor* e, int fd, uint64_t start, uint64_t end, bool positioned) {
+    uint64_t run;
+    while (start < end) {
+        const char* data = piece_at(&e->pieces, start, &run);
+        if (run > end - start) run = end - start;
+        if (run > SSIZE_MAX) run = SSIZE_MAX;
+        ssize_t bw = positioned ? pwrite(fd, data, run, start) : write(fd, data, run);
+        if (bw < 0 && errno == EINTR) continue;
+        if (bw <= 0) return false;
+        start += bw;
+    }
+    return true;
+}
+
+// Same-size edits are patched into the file with pwrite, one call per dirty
+// range. Anything that moved bytes is written to a temp file next to the
+// target, synced and renamed over it, so a crash never leaves a torn file.
+
+static bool editor_write_inplace(struct editor* e, const char* path) {
+    int fd = open(path, O_WRONLY);
+    if (fd == -1) return false;
+    for (size_t i = 0; i < e->dirty_count; i++)
+        if (!editor_write_range(e, fd, e->dirty_ranges[i].start, e->dirty_ranges[i].end, true)) {
+            close(fd);
+            return false;
+        }
+    return close(fd) == 0;
+}
+
+// Makes a rename in the directory holding path durable. Filesystems that
+// cannot sync a directory say EINVAL, which is not an error here.
+
+static bool editor_sync_dir(const char* path) {
+    char dir[PATH_MAX];
+    const char* slash = strrchr(path, '/');
+    if (slash == NULL) strcpy(dir, ".");
+    else if (slash == path) strcpy(dir, "/");
+    else snprintf(dir, sizeof(dir), "%.*s", (int) (slash - path), path);
+
+    int fd = open(dir, O_RDONLY | O_DIRECTORY);
+    if (fd == -1) return false;
+    bool ok = fsync(fd) == 0 || errno == EINVAL;
+    int err = errno;
+    close(fd);
+    errno = err;
+    return ok;
+}
+
+static bool editor_write_atomic(struct editor* e, const char* path) {
+    char tmp[PATH_MAX];
+    struct stat st;
+    if (snprintf(tmp, sizeof(tmp), "%s.XXXXXX", path) >= (int) sizeof(tmp)) { errno = ENAMETOOLONG; return false; }
+
+    int fd = mkstemp(tmp);
+    if (fd == -1) return false;
+
+    bool ok = editor_write_range(e, fd, 0, e->content_length, false);
+    if (ok && stat(path, &st) == 0) {
+        // Only root may give a file away; others keep their own ownership.
+        if (fchown(fd, st.st_uid, st.st_gid) == -1 && errno != EPERM) ok = false;
+        ok = ok && fchmod(fd, st.st_mode & 07777) == 0;
+    } else if (ok) {
+        // A new file gets the mode open(2) would give it, not mkstemp's 0600.
+        mode_t mask = umask(0);
+        umask(mask);
+        ok = fchmod(fd, 0666 & ~mask) == 0;
+    }
+    ok = ok && fsync(fd) == 0;
+    ok = close(fd) == 0 && ok;
+    ok = ok && rename(tmp, path) == 0;
+    if (!ok) {
+        int err = errno;
+        unlink(tmp);
+        errno = err;
+        return false;
+    }
+    return editor_sync_dir(path);
+}
+
 void editor_writefile(struct editor* e) {
     assert(e->filename != NULL);
 
-    FILE* fp = fopen(e->filename, "wb");
-    if (fp == NULL) {
-        editor_statusmessage(e, STATUS_ERROR, "Unable to open '%s' for writing: %s", e->filename, strerror(errno));
-        return;
-    }
+    char resolved[PATH_MAX];
+    const char* path = realpath(e->filename, resolved) ? resolved : e->filename;
+    bool inplace = !e->resized && access(path, F_OK) == 0;
+    uint64_t written = 0;
+    for (size_t i = 0; inplace && i < e->dirty_count; i++) written += e->dirty_ranges[i].end - e->dirty_ranges[i].start;
 
-    size_t bw = fwrite(e->contents, sizeof(char), e->content_length, fp);
-    if (bw <= 0) {
-        editor_statusmessage(e, STATUS_ERROR, "Unable write to file: %s", strerror(errno));
+    if (!(inplace ? editor_write_inplace(e, path) : editor_write_atomic(e, path))) {
+        editor_statusmessage(e, STATUS_ERROR, "Unable write to '%s': %s", e->filename, strerror(errno));
         return;
     }
 
-    editor_statusmessage(e, STATUS_INFO, "\"%s\", %d bytes written", e->filename, e->content_length);
+    if (inplace) editor_statusmessage(e, STATUS_INFO, "\"%s\", %" PRIu64 " bytes patched in %zu ranges", e->filename, written, e->dirty_count);
+    else editor_statusmessage(e, STATUS_INFO, "\"%s\", %" PRIu64 " bytes written", e->filename, e->content_length);
     e->dirty = false;
-
-    fclose(fp);
+    e->resized = false;
+    e->dirty_count = 0;
 }
 
 void editor_setview(struct editor* e, enum editor_view view) {
@@ -249,7 +766,7 @@ void editor_setview(struct editor* e, enum editor_view view) {
             editor_statusmessage(e, STATUS_INFO, "View: ASM");
             break;
         case VIEW_HEX:
-            editor_scroll_to_offset(e, e->line * e->octets_per_line);
+            editor_scroll_to_offset_hex(e, e->line * e->octets_per_line);
             e->cursor_x = e->hex_x;
             e->cursor_y = e->hex_y;
             editor_statusmessage(e, STATUS_INFO, "View: HEX");
@@ -260,6 +777,8 @@ void editor_setview(struct editor* e, enum editor_view view) {
 
 void editor_setmode(struct editor* e, enum editor_mode mode) {
     e->mode = mode;
+    undo_seal(&e->undo);
+    if (e->view == VIEW_HEX) editor_cursor_at_offset(e, editor_offset_at_cursor(e), &e->cursor_x, &e->cursor_y);
     switch (e->mode) {
         case MODE_NORMAL:        editor_statusmessage(e, STATUS_INFO, ""); break;
         case MODE_APPEND:        editor_statusmessage(e, STATUS_INFO, "Mode: APPEND"); break;
@@ -299,19 +818,18 @@ void editor_render_header(struct editor* e, struct charbuf* b) {
 
     if (e->seg_size > 32) strcpy(arch[2], "AArch64\0");
 
-    int current_offset =  editor_offset_at_cursor(e);
-    unsigned char active_byte = e->contents[current_offset];
+    uint64_t current_offset =  editor_offset_at_cursor(e);
+    unsigned char active_byte = editor_byte_at(e, current_offset);
     int arch_select = e->arch < 0 ? 0 : (e->arch > 9 ? 0 : e->arch);
     banlen = snprintf(banner, sizeof(banner),
-           "\x1b[1;33m\x1b[33;44m▄\x1b[48;2;255;105;180m\x1b[1;37m BE \x1b[90;106m %12s [%03i][%s][%02x][%016x] Size: %012iB    ",
+           "\x1b[1;33m\x1b[33;44m▄\x1b[48;2;255;105;180m\x1b[1;37m BE \x1b[90;106m %12s [%03i][%s][%02x][%016" PRIx64 "] Size: %012" PRIu64 "B    ",
            arch[arch_select],
            e->seg_size, (e->view == VIEW_ASM ? "ASM" : "HEX"), active_byte,
            current_offset, e->content_length);
     charbuf_append(b, banner, banlen);
 
-    unsigned int offset_at_cursor = editor_offset_at_cursor(e);
-    unsigned char val = e->contents[offset_at_cursor];
-    int percentage = (float)(offset_at_cursor + 1) / ((float)e->content_length) * 100;
+    uint64_t offset_at_cursor = editor_offset_at_cursor(e);
+    int percentage = e->content_length ? (double)(offset_at_cursor + 1) / ((double)e->content_length) * 100 : 0;
     charbuf_appendf(b, "\x1b[1;37m\x1b[46m");
     int width = e->screen_cols - (16+32+64) - 38;
     char *format = "% 36d%% ";
@@ -338,7 +856,12 @@ void editor_render_help(struct editor* e) {
         "\r\n"
         "CTRL+Q  : Quit immediately without saving.\r\n"
         "CTRL+S  : Save (in place).\r\n"
+        "u       : Undo the last change.\r\n"
+        "CTRL+R  : Redo the last undone change.\r\n"
         "Arrows  : Also moves the cursor around.\r\n"
+        "/       : Search; n and N repeat it forward and backward.\r\n"
+        ":findall: Search all patterns of a file at once; n and N walk the hits.\r\n"
+        ":patch  : Apply an IPS file or `offset: hexbytes` listing as one undo step.\r\n"
         "\r\n");
 
     charbuf_appendf(b,
@@ -373,9 +896,9 @@ void editor_render_status(struct editor* e, struct charbuf* b) {
 void editor_process_command(struct editor* e, const char* cmd) {
     bool b = is_pos_num(cmd);
     if (b) {
-        int offset = str2int(cmd, 0, e->content_length, e->content_length - 1);
+        uint64_t offset = str2u64(cmd, e->content_length, e->content_length ? e->content_length - 1 : 0);
         editor_scroll_to_offset(e, offset);
-        editor_statusmessage(e, STATUS_INFO, "Positioned to offset 0x%09x (%d)", offset, offset);
+        editor_statusmessage(e, STATUS_INFO, "Positioned to offset 0x%09" PRIx64 " (%" PRIu64 ")", offset, offset);
         return;
     }
 
@@ -386,9 +909,9 @@ void editor_process_command(struct editor* e, const char* cmd) {
             return;
         }
 
-        int offset = hex2int(ptr);
+        uint64_t offset = hex2u64(ptr);
         editor_scroll_to_offset(e, offset);
-        editor_statusmessage(e, STATUS_INFO, "Positioned to offset 0x%09x (%d)", offset, offset);
+        editor_statusmessage(e, STATUS_INFO, "Positioned to offset 0x%09" PRIx64 " (%" PRIu64 ")", offset, offset);
         return;
     }
 
@@ -416,6 +939,28 @@ void editor_process_command(struct editor* e, const char* cmd) {
         return;
     }
 
+    if (strncmp(cmd, "findall", 7) == 0) {
+        const char* path = cmd + 7;
+        while (*path == ' ') path++;
+        if (cmd[7] != ' ' || *path == '\0') {
+            editor_statusmessage(e, STATUS_ERROR, "findall command format: `findall <patternfile>`");
+            return;
+        }
+        editor_findall(e, path);
+        return;
+    }
+
+    if (strncmp(cmd, "patch", 5) == 0) {
+        const char* path = cmd + 5;
+        while (*path == ' ') path++;
+        if (cmd[5] != ' ' || *path == '\0') {
+            editor_statusmessage(e, STATUS_ERROR, "patch command format: `patch <ips or listing file>`");
+            return;
+        }
+        editor_patch(e, path);
+        return;
+    }
+
     if (strncmp(cmd, "set", 3) == 0) {
         char setcmd[INPUT_BUF_SIZE] = {0};
         int setval = 0;
@@ -429,9 +974,9 @@ void editor_process_command(struct editor* e, const char* cmd) {
         if (strcmp(setcmd, "octets") == 0 || strcmp(setcmd, "o") == 0) {
             int octets = clampi(setval, 16, 64);
             clear_screen();
-            int offset = editor_offset_at_cursor(e);
+            uint64_t offset = editor_offset_at_cursor(e);
             e->octets_per_line = octets;
-            editor_scroll_to_offset(e, offset);
+            editor_scroll_to_offset_hex(e, offset);
             editor_statusmessage(e, STATUS_INFO, "Octets per line set to %d", octets);
             return;
         }
@@ -444,6 +989,12 @@ void editor_process_command(struct editor* e, const char* cmd) {
             return;
         }
 
+        if (strcmp(setcmd, "fps") == 0) {
+            e->frame_rate = clampi(setval, 1, 1000);
+            editor_statusmessage(e, STATUS_INFO, "Screen refresh limited to %d frames per second", e->frame_rate);
+            return;
+        }
+
         editor_statusmessage(e, STATUS_ERROR, "Unknown option: %s", setcmd);
         return;
     }
@@ -487,8 +1038,15 @@ int editor_read_string(struct editor* e, char* dst, int len) {
 
 void editor_free(struct editor* e) {
     struct editor* x = editor();
+    editor_search_cancel(x);
     free(x->filename);
-    free(x->contents);
+    piece_free(&x->pieces);
+    undo_free(&x->undo);
+    free(x->dirty_ranges);
+    free(x->hits);
+    charbuf_free(x->frame);
+    if (x->mapping_size) munmap(x->contents, x->mapping_size);
+    else free(x->contents);
     free(x);
 }
 
@@ -506,6 +1064,13 @@ void editor_insert_byte(struct editor* e, char x, bool after) {
     }
 }
 
+void editor_delete_byte(struct editor* e) {
+    switch (e->view) {
+        case VIEW_HEX: editor_delete_byte_hex(e); break;
+        default:       break;
+    }
+}
+
 void editor_scroll(struct editor* e, int units) {
     switch (e->view) {
         case VIEW_ASM:  editor_scroll_dasm(e, units); break;
@@ -513,6 +1078,13 @@ void editor_scroll(struct editor* e, int units) {
     }
 }
 
+void editor_scroll_to_offset(struct editor* e, uint64_t offset) {
+    switch (e->view) {
+        case VIEW_ASM:  editor_scroll_to_offset_dasm(e, offset); break;
+        default:        editor_scroll_to_offset_hex(e, offset);
+    }
+}
+
 void editor_move_cursor(struct editor* e, int dir, int amount) {
     switch (e->view) {
         case VIEW_ASM: editor_move_cursor_dasm(e, dir, amount); break;
@@ -563,8 +1135,38 @@ int editor_read_hex_input(struct editor* e, char* out) {
     return -1;
 }
 
+enum key_axis { AXIS_NONE, AXIS_ROW, AXIS_PAGE };
+
+static enum key_axis key_axis(int c, int* sign) {
+    switch (c) {
+        case KEY_UP:     *sign = -1; return AXIS_ROW;
+        case KEY_DOWN:   *sign = 1;  return AXIS_ROW;
+        case KEY_CTRL_U:
+        case KEY_PGUP:   *sign = -1; return AXIS_PAGE;
+        case KEY_CTRL_D:
+        case KEY_PGDOWN: *sign = 1;  return AXIS_PAGE;
+    }
+    return AXIS_NONE;
+}
+
+// Folds the vertical keys already queued behind c into one signed count, so
+// a held arrow or PgDown moves once per batch instead of once per repeat.
+
+static int editor_key_run(int c) {
+    int sign = 0, net, next;
+    enum key_axis axis = key_axis(c, &sign);
+    for (net = sign; (next = peek_key()) != -1 && key_axis(next, &sign) == axis; net += sign) read_key();
+    return net;
+}
+
 void editor_process_keypress(struct editor* e) {
 
+    if (peek_key() == KEY_PASTE) {
+        read_key();
+        editor_paste(e);
+        return;
+    }
+
     if (e->mode & (MODE_INSERT | MODE_APPEND)) {
         char out = 0;
         if (editor_read_hex_input(e, &out) != -1) {
@@ -619,7 +1221,10 @@ void editor_process_keypress(struct editor* e) {
     if (e->mode & MODE_SEARCH) {
         char search[INPUT_BUF_SIZE];
         int c = editor_read_string(e, search, INPUT_BUF_SIZE);
-        if (c == KEY_ENTER && strlen(search) > 0) editor_process_search(e, search, SEARCH_FORWARD);
+        if (c == KEY_ENTER && strlen(search) > 0) {
+            e->hit_count = 0;
+            editor_process_search(e, search, SEARCH_FORWARD);
+        }
         return;
     }
 
@@ -627,7 +1232,9 @@ void editor_process_keypress(struct editor* e) {
     if (c == -1) return;
 
     switch (c) {
-        case KEY_ESC:    editor_setmode(e, MODE_NORMAL); return;
+        case KEY_ESC:    if (editor_search_cancel(e)) editor_statusmessage(e, STATUS_WARNING, "Search cancelled");
+                         else editor_setmode(e, MODE_NORMAL);
+                         return;
         case KEY_CTRL_Q: exit(0); return;
         case KEY_F3: exit(0); return;
         case KEY_CTRL_S: editor_writefile(e); return;
@@ -637,7 +1244,11 @@ void editor_process_keypress(struct editor* e) {
     {
         switch (c) {
         case KEY_UP:
-        case KEY_DOWN:
+        case KEY_DOWN: {
+            int rows = editor_key_run(c);
+            if (rows) editor_move_cursor(e, rows > 0 ? KEY_DOWN : KEY_UP, abs(rows));
+            return;
+        }
         case KEY_RIGHT:
         case KEY_LEFT: editor_move_cursor(e, c, 1); return;
         case '1': e->cursor_x = 1; editor_statusmessage(e, STATUS_INFO, "Bitness: %i", e->seg_size = 8); return;
@@ -647,26 +1258,36 @@ void editor_process_keypress(struct editor* e) {
         case '5': e->cursor_x = 1; editor_statusmessage(e, STATUS_INFO, "Bitness: %i", e->seg_size = 128); return;
         case 'd': editor_setview(e, VIEW_ASM); return;
         case 'x': editor_setview(e, VIEW_HEX); return;
-//      case 'a': editor_setmode(e, MODE_APPEND);       return;
+        case 'a': editor_setmode(e, MODE_APPEND);       return;
 //      case 'A': editor_setmode(e, MODE_APPEND_ASCII); return;
-//      case 'i': editor_setmode(e, MODE_INSERT);       return;
+        case 'i': editor_setmode(e, MODE_INSERT);       return;
 //      case 'I': editor_setmode(e, MODE_INSERT_ASCII); return;
         case 'r': editor_setmode(e, MODE_REPLACE);      return;
         case 'R': editor_setmode(e, MODE_REPLACE_ASCII);return;
         case ':': editor_setmode(e, MODE_COMMAND);      return;
         case '/': editor_setmode(e, MODE_SEARCH);       return;
+        case 'n': if (e->hit_count) editor_next_hit(e, SEARCH_FORWARD);
+                  else editor_process_search(e, e->searchstr, SEARCH_FORWARD);  return;
+        case 'N': if (e->hit_count) editor_next_hit(e, SEARCH_BACKWARD);
+                  else editor_process_search(e, e->searchstr, SEARCH_BACKWARD); return;
+        case KEY_DELETE: editor_delete_byte(e);         return;
+        case 'u': editor_undo(e, false);                return;
+        case KEY_CTRL_R: editor_undo(e, true);          return;
+        case KEY_ENTER: if (e->view == VIEW_ASM) editor_follow_dasm(e); return;
         case KEY_HOME: e->cursor_x = 1; return;
         case KEY_END:  editor_move_cursor(e, KEY_RIGHT, e->octets_per_line - e->cursor_x); return;
         case KEY_CTRL_U:
-        case KEY_PGUP:   editor_scroll(e, -(e->screen_rows) + 2); return;
+        case KEY_PGUP:
         case KEY_CTRL_D:
-        case KEY_PGDOWN: editor_scroll(e, e->screen_rows - 2); return;
+        case KEY_PGDOWN: editor_scroll(e, editor_key_run(c) * (e->screen_rows - 2)); return;
         }
     }
 }
 
 void editor_refresh_screen(struct editor* e) {
-    struct charbuf* b = charbuf_create();
+    struct charbuf* b = e->frame;
+    charbuf_reset(b);
+    charbuf_reserve(b, (size_t) e->screen_rows * e->screen_cols * FRAME_CELL_BYTES);
     charbuf_append(b, "\x1b[?25l", 6);
     charbuf_append(b, "\x1b[H", 3);
     if (e->mode & MODE_COMMAND) {
@@ -680,6 +1301,5 @@ void editor_refresh_screen(struct editor* e) {
         editor_render_contents(e, b);
         editor_render_status(e, b);
     }
-    charbuf_draw(b);
-    charbuf_free(b);
+    screen_draw(b->contents, b->len, e->screen_rows, e->screen_cols);
 }
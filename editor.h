@@ -4,7 +4,10 @@
 #include <unistd.h>
 #include <sys/ioctl.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include "term/buffer.h"
+#include "hex/piece.h"
+#include "hex/undo.h"
 
 enum editor_view {
     VIEW_HEX = 1,
@@ -47,11 +50,26 @@ enum status_severity {
 };
 
 #define INPUT_BUF_SIZE 80
+#define EDITOR_MAP_PAD 4096
+#define FRAME_CELL_BYTES 16
+#define FRAME_RATE 60
+
+struct dirty_range {
+    uint64_t start;
+    uint64_t end;
+};
+
+struct search_job;
+
+struct search_hit {
+    uint64_t offset;
+    uint32_t pattern;
+};
 
 struct editor {
     int octets_per_line;
     int grouping;
-    int line;
+    int64_t line;
     int cursor_x;
     int cursor_y;
     int hex_x;
@@ -60,18 +78,32 @@ struct editor {
     int screen_cols;
     enum editor_mode mode;
     bool dirty;
+    bool resized;
+    struct dirty_range* dirty_ranges;
+    size_t dirty_count;
+    size_t dirty_cap;
     char* filename;
     char* contents;
-    unsigned long offset_dasm;
-    unsigned long offset_hex;
+    size_t mapping_size;
+    struct piece_table pieces;
+    struct undo_journal undo;
+    uint64_t offset_dasm;
+    uint64_t offset_hex;
     enum editor_view view;
     enum dasm_arch arch;
-    unsigned int content_length;
+    uint64_t content_length;
     enum status_severity status_severity;
     char status_message[120];
     char inputbuffer[INPUT_BUF_SIZE];
     int inputbuffer_index;
     char searchstr[INPUT_BUF_SIZE];
+    struct search_job* search;
+    struct charbuf* frame;
+    struct search_hit* hits;
+    size_t hit_count;
+    size_t hit_cap;
+    size_t hit_pos;
+    int frame_rate;
     int seg_size;
 };
 
@@ -86,6 +118,14 @@ struct editor* editor();
 struct editor* editor_init();
 void editor_free(struct editor* e);
 void editor_openfile(struct editor* e, const char* filename);
+unsigned char editor_byte_at(struct editor* e, uint64_t offset);
+const char* editor_span(struct editor* e, uint64_t offset, uint64_t length, char* scratch);
+void editor_write_bytes(struct editor* e, uint64_t offset, const char* data, uint64_t length);
+void editor_insert_bytes(struct editor* e, uint64_t offset, const char* data, uint64_t length);
+void editor_delete_bytes(struct editor* e, uint64_t offset, uint64_t length);
+void editor_undo(struct editor* e, bool redo);
+void editor_search_poll(struct editor* e);
+bool editor_search_cancel(struct editor* e);
 void editor_refresh_screen(struct editor* e);
 void editor_setmode(struct editor *e, enum editor_mode mode);
 void editor_setview(struct editor *e, enum editor_view view);
@@ -95,5 +135,6 @@ void editor_writefile(struct editor* e);
 void editor_move_cursor(struct editor* e, int dir, int amount);
 void editor_process_keypress(struct editor* e);
 void editor_scroll(struct editor* e, int units);
+void editor_scroll_to_offset(struct editor* e, uint64_t offset);
 
 #endif
@@ -1,5 +1,7 @@
 #include <assert.h>
+#include <ctype.h>
 #include <errno.h>
+#include <inttypes.h>
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -21,32 +23,76 @@ void editor_move_cursor_hex(struct editor* e, int dir, int amount) {
     if (e->cursor_x < 1) { if (e->cursor_y >= 1) { e->cursor_y--; e->cursor_x = e->octets_per_line; } }
     else if (e->cursor_x > e->octets_per_line) { e->cursor_y++; e->cursor_x = 1; }
     if (e->cursor_y <= 1 && e->line <= 0) e->cursor_y = 1;
-    if (e->cursor_y > e->screen_rows - 2) { e->cursor_y = e->screen_rows - 2; editor_scroll(e, 1); }
-    else if (e->cursor_y < 1 && e->line > 0) { e->cursor_y = 1; editor_scroll(e, -1); }
+    if (e->cursor_y > e->screen_rows - 2) { editor_scroll(e, e->cursor_y - (e->screen_rows - 2)); e->cursor_y = e->screen_rows - 2; }
+    else if (e->cursor_y < 1 && e->line > 0) { editor_scroll(e, e->cursor_y - 1); e->cursor_y = 1; }
 
-    unsigned int offset = editor_offset_at_cursor(e);
-    if (offset >= e->content_length - 1) { editor_cursor_at_offset(e, offset, &e->cursor_x, &e->cursor_y); return; }
+    uint64_t offset = editor_offset_at_cursor(e);
+    if (offset + 1 >= e->content_length) { editor_cursor_at_offset(e, offset, &e->cursor_x, &e->cursor_y); return; }
 }
 
-void editor_cursor_at_offset(struct editor* e, int offset, int* x, int* y) {
+void editor_cursor_at_offset(struct editor* e, uint64_t offset, int* x, int* y) {
     *x = offset % e->octets_per_line + 1;
-    *y = offset / e->octets_per_line - e->line + 1;
+    *y = (int64_t)(offset / e->octets_per_line) - e->line + 1;
 }
 
-int editor_offset_at_cursor(struct editor* e) {
-    unsigned int offset = (e->cursor_y - 1 + e->line) * e->octets_per_line + (e->cursor_x - 1);
-    if (offset <= 0) return 0;
-    if (offset >= e->content_length) return e->content_length - 1;
+// Insert mode lets the cursor sit one past the last byte, so typing at the
+// end of the buffer appends in order.
+
+uint64_t editor_offset_at_cursor(struct editor* e) {
+    int64_t offset = (e->cursor_y - 1 + e->line) * e->octets_per_line + (e->cursor_x - 1);
+    uint64_t last = e->mode & (MODE_INSERT | MODE_INSERT_ASCII) ? e->content_length : e->content_length - 1;
+    if (offset <= 0 || e->content_length == 0) return 0;
+    if ((uint64_t) offset >= last) return last;
     return offset;
 }
 
 void editor_scroll_hex(struct editor* e, int units) {
     e->line += units;
-    int upper_limit = e->content_length / e->octets_per_line - (e->screen_rows - 3);
+    int64_t upper_limit = (int64_t)(e->content_length / e->octets_per_line) - (e->screen_rows - 3);
     if (e->line >= upper_limit) e->line = upper_limit;
     if (e->line <= 0) e->line = 0;
 }
 
+// Row emitter: every piece of a row is a precomputed string copied into the
+// charbuf, so a repaint does no formatting at all.
+
+#define SGR(s) { s, sizeof(s) - 1 }
+
+struct sgr { const char* s; size_t len; };
+
+static const struct sgr sgr_offset[2] = { SGR("\x1b[0;93m\x1b[0;104m"), SGR("\x1b[1;97m\x1b[45m") };
+static const struct sgr sgr_cell[2][2] = {                 // [separator][cursor]
+    { SGR("\x1b[1;36m\x1b[0;36m \x1b[4;94m"), SGR("\x1b[1;36m\x1b[0;36m \x1b[1;37m\x1b[43m") },
+    { SGR("\x1b[0;36m\x1b[0;37m-\x1b[4;94m"), SGR("\x1b[0;36m\x1b[0;37m-\x1b[1;37m\x1b[43m") },
+};
+static const struct sgr sgr_ascii[2] = { SGR("\x1b[0;104m"), SGR("\x1b[1;97m\x1b[45m") };
+static const struct sgr sgr_reset = SGR("\x1b[0m");
+static const struct sgr sgr_gutter = SGR("\x1b[43m\x1b[0;37m \x1b[0;104m\x1b[1;37m");
+static const struct sgr sgr_eol = SGR("\x1b[0m\x1b[K");
+
+static char hex_pairs[256][2];
+static char hex_ascii[256];
+
+static void hex_tables() {
+    static const char digits[] = "0123456789abcdef";
+    if (hex_ascii[0] != '\0') return;
+    for (int c = 0; c < 256; c++) {
+        hex_pairs[c][0] = digits[c >> 4];
+        hex_pairs[c][1] = digits[c & 0xF];
+        hex_ascii[c] = isprint(c) ? c : '.';
+    }
+}
+
+static inline void emit(struct charbuf* b, struct sgr s) {
+    charbuf_append(b, s.s, s.len);
+}
+
+static void emit_offset(struct charbuf* b, uint64_t offset) {
+    char digits[16];
+    for (int i = 0; i < 8; i++) memcpy(digits + 2 * i, hex_pairs[(offset >> (56 - 8 * i)) & 0xFF], 2);
+    charbuf_append(b, digits, 16);
+}
+
 void editor_render_hex(struct editor* e, struct charbuf* b) {
 
     if (e->content_length <= 0) {
@@ -55,105 +101,84 @@ void editor_render_hex(struct editor* e, struct charbuf* b) {
         return;
     }
 
-    char hex[ 32 + 1];
-    int  hexlen = 0;
-    char asc[256 + 1];
-    int row_char_count = 0;
-
-    unsigned int start_offset = e->line * e->octets_per_line;
+    hex_tables();
+    uint64_t start_offset = e->line * e->octets_per_line;
     if (start_offset >= e->content_length) start_offset = e->content_length - e->octets_per_line;
 
     int bytes_per_screen = (e->screen_rows - 1) * e->octets_per_line;
-    unsigned int end_offset = bytes_per_screen + start_offset - e->octets_per_line;
+    uint64_t end_offset = bytes_per_screen + start_offset - e->octets_per_line;
     if (end_offset > e->content_length) end_offset = e->content_length;
 
-    unsigned int offset;
+    int group = e->seg_size / 8;
+    char rowbuf[64];
     int row = 0;
-    int col = 0;
-    int current_offset =  editor_offset_at_cursor(e);
-
-    for (offset = start_offset; offset < end_offset; offset++) {
-
-        unsigned char curr_byte = e->contents[offset];
-
-        if (offset % e->octets_per_line == 0) {
-            if (row + 1 == e->cursor_y) charbuf_appendf(b, "\x1b[1;97m\x1b[45m");
-            else charbuf_appendf(b, "\x1b[0;93m\x1b[0;104m");
-            charbuf_appendf(b, "%016x\x1b[0m", offset);
-            memset(asc, '\0', sizeof(asc));
-            row_char_count = 0;
-            col = 0;
-            row++;
+    for (uint64_t row_offset = start_offset; row_offset < end_offset; row_offset += e->octets_per_line) {
+        const unsigned char* data = (const unsigned char*) editor_span(e, row_offset, e->octets_per_line, rowbuf);
+        int count = end_offset - row_offset < (uint64_t) e->octets_per_line ? (int) (end_offset - row_offset) : e->octets_per_line;
+        row++;
+
+        emit(b, sgr_offset[row == e->cursor_y]);
+        emit_offset(b, row_offset);
+        emit(b, sgr_reset);
+
+        for (int col = 1; col <= count; col++) {
+            unsigned char byte = data[col - 1];
+            bool cursor = row == e->cursor_y && col == e->cursor_x;
+            emit(b, sgr_cell[(3 * (col - 1)) % group != 0][cursor]);
+            if (cursor) {
+                memset(hexstr()+1, '\0', 1);
+                if (hexstr_idx() == 1 && e->mode == MODE_REPLACE)
+                    byte = byte & 0xF | hex2bin(hexstr()) & 0xF << 4;
+            }
+            charbuf_append(b, hex_pairs[byte], 2);
+            emit(b, sgr_reset);
         }
 
-        col++;
-
-        hexlen = snprintf(hex, sizeof(hex), "%02x", curr_byte);
-
-        if (isprint(curr_byte)) asc[offset % e->octets_per_line] = curr_byte;
-        else asc[offset % e->octets_per_line] = '.';
-
-        if ((row_char_count % (e->seg_size / 8) != 0)) charbuf_appendf(b, "\x1b[0;36m\x1b[0;37m-");
-        else charbuf_appendf(b, "\x1b[1;36m\x1b[0;36m ");
-	row_char_count++;
-
-	if (e->cursor_y == row && e->cursor_x == col)
-        {
-            charbuf_appendf(b, "\x1b[1;37m\x1b[43m");
-            memset(hexstr()+1, '\0', 1);
-            if (hexstr_idx() == 1 && e->mode == MODE_REPLACE)
-                hexlen = snprintf(hex, sizeof(hex), "%02x",
-                curr_byte & 0xF | hex2bin(hexstr()) & 0xF << 4);
-        } else {
-	    charbuf_appendf(b, "\x1b[4;94m");
-        }
-
-        charbuf_append(b, hex, hexlen);
-        charbuf_append(b, "\x1b[0m", 5);
-        row_char_count += 2;
-
-        if ((offset+1) % e->octets_per_line == 0)
-        {
-
-            charbuf_appendf(b, "\x1b[43m\x1b[0;37m \x1b[0;104m\x1b[1;37m");
-            int the_offset = offset + 1 - e->octets_per_line;
-            editor_render_ascii(e, row, the_offset, b);
+        if (count == e->octets_per_line) {
+            emit(b, sgr_gutter);
+            editor_render_ascii(e, row, data, count, b);
             charbuf_append(b, "\r\n", 2);
-	}
+        }
     }
     charbuf_append(b, "\x1b[0K", 4);
 }
 
-void editor_render_ascii(struct editor* e, int rownum, unsigned int start_offset, struct charbuf* b) {
-    int cc = 0;
-    for (unsigned int offset = start_offset; offset < start_offset + e->octets_per_line; offset++) {
-        if (offset >= e->content_length) return;
-        cc++;
-        char c =  e->contents[offset];
-        if (rownum == e->cursor_y && cc == e->cursor_x) charbuf_appendf(b, "\x1b[1;97m\x1b[45m");
-	else charbuf_appendf(b, "\x1b[0;104m");
-	if (isprint(c)) charbuf_appendf(b, "%c", c); else charbuf_append(b, ".", 1);
+// Runs of plain characters share one SGR; only the cursor cell breaks them.
+
+void editor_render_ascii(struct editor* e, int rownum, const unsigned char* data, int count, struct charbuf* b) {
+    char text[64];
+    int cursor = rownum == e->cursor_y ? e->cursor_x - 1 : -1;
+    for (int i = 0; i < count; i++) text[i] = hex_ascii[data[i]];
+
+    if (cursor < 0 || cursor >= count) {
+        emit(b, sgr_ascii[0]);
+        charbuf_append(b, text, count);
+    } else {
+        if (cursor > 0) { emit(b, sgr_ascii[0]); charbuf_append(b, text, cursor); }
+        emit(b, sgr_ascii[1]);
+        charbuf_append(b, text + cursor, 1);
+        if (cursor + 1 < count) { emit(b, sgr_ascii[0]); charbuf_append(b, text + cursor + 1, count - cursor - 1); }
     }
-    charbuf_append(b, "\x1b[0m\x1b[K", 7);
+    emit(b, sgr_eol);
 }
 
-void editor_scroll_to_offset(struct editor* e, unsigned int offset) {
+void editor_scroll_to_offset_hex(struct editor* e, uint64_t offset) {
     if (offset > e->content_length) {
-        editor_statusmessage(e, STATUS_ERROR, "Out of range: 0x%09x (%u)", offset, offset);
+        editor_statusmessage(e, STATUS_ERROR, "Out of range: 0x%09" PRIx64 " (%" PRIu64 ")", offset, offset);
         return;
     }
 
-    unsigned int offset_min = e->line * e->octets_per_line;
-    unsigned int offset_max = offset_min + (e->screen_rows * e->octets_per_line);
+    uint64_t offset_min = e->line * e->octets_per_line;
+    uint64_t offset_max = offset_min + (e->screen_rows * e->octets_per_line);
 
     if (offset >= offset_min && offset <= offset_max) {
         editor_cursor_at_offset(e, offset, &(e->cursor_x), &(e->cursor_y));
         return;
     }
 
-    e->line = offset / e->octets_per_line - (e->screen_rows / 2);
+    e->line = (int64_t)(offset / e->octets_per_line) - (e->screen_rows / 2);
 
-    int upper_limit = e->content_length / e->octets_per_line - (e->screen_rows - 2);
+    int64_t upper_limit = (int64_t)(e->content_length / e->octets_per_line) - (e->screen_rows - 2);
     if (e->line >= upper_limit) e->line = upper_limit;
     if (e->line <= 0) e->line = 0;
 
@@ -163,27 +188,32 @@ void editor_scroll_to_offset(struct editor* e, unsigned int offset) {
 void editor_insert_byte_hex(struct editor* e, char x, bool after) {
     hexstr_set(0,0); hexstr_set(1,0); hexstr_set(2,0);
     hexstr_idx_set(0);
-    int offset = editor_offset_at_cursor(e);
+    uint64_t offset = editor_offset_at_cursor(e);
     editor_insert_byte_at_offset(e, offset, x, after);
 }
 
-void editor_insert_byte_at_offset(struct editor* e, unsigned int offset, char x, bool after) {
-    e->contents = realloc(e->contents, e->content_length + 1);
+void editor_insert_byte_at_offset(struct editor* e, uint64_t offset, char x, bool after) {
     if (after && e->content_length) offset++;
-    memmove(e->contents + offset + 1, e->contents + offset, e->content_length - offset);
-    e->contents[offset] = x;
-    e->content_length++;
-    e->dirty = true;
+    editor_insert_bytes(e, offset, &x, 1);
+}
+
+void editor_delete_byte_hex(struct editor* e) {
+    if (e->content_length == 0) {
+        editor_statusmessage(e, STATUS_ERROR, "File is empty, nothing to delete");
+        return;
+    }
+    uint64_t offset = editor_offset_at_cursor(e);
+    editor_delete_bytes(e, offset, 1);
+    if (offset >= e->content_length && offset > 0) editor_move_cursor(e, KEY_LEFT, 1);
+    editor_statusmessage(e, STATUS_INFO, "Deleted byte at offset %09" PRIx64, offset);
 }
 
 void editor_replace_byte_hex(struct editor* e, char x) {
     hexstr_set(0,0); hexstr_set(1,0); hexstr_set(2,0);
     hexstr_idx_set(0);
-    unsigned int offset = editor_offset_at_cursor(e);
-    unsigned char prev = e->contents[offset];
-    e->contents[offset] = x;
+    uint64_t offset = editor_offset_at_cursor(e);
+    editor_write_bytes(e, offset, &x, 1);
     editor_move_cursor(e, KEY_RIGHT, 1);
-    editor_statusmessage(e, STATUS_INFO, "Replaced byte at offset %09x with %02x", offset, (unsigned char) x);
-    e->dirty = true;
+    editor_statusmessage(e, STATUS_INFO, "Replaced byte at offset %09" PRIx64 " with %02x", offset, (unsigned char) x);
 }
 
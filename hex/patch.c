@@ -0,0 +1,163 @@
+// BE: INFOSEC BINARY HEX EDITOR WITH DASM
+// Synrc Research (c) 2022-2025
+// 5HT DHARMA License
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "patch.h"
+
+void patch_init(struct patch* p) {
+    memset(p, 0, sizeof(*p));
+}
+
+void patch_free(struct patch* p) {
+    free(p->sites);
+    free(p->data);
+    patch_init(p);
+}
+
+static bool patch_fail(struct patch* p, const char* error) {
+    p->error = error;
+    return false;
+}
+
+// Adds a site of length bytes and returns where its bytes go.
+
+static char* patch_site(struct patch* p, uint64_t offset, uint64_t length) {
+    if (p->count == p->cap) {
+        p->cap = p->cap ? p->cap * 2 : 64;
+        p->sites = realloc(p->sites, p->cap * sizeof(struct patch_site));
+        if (p->sites == NULL) { perror("Unable to grow patch"); exit(1); }
+    }
+    if (p->len + length > p->data_cap) {
+        uint64_t cap = p->data_cap ? p->data_cap * 2 : 4096;
+        while (cap < p->len + length) cap *= 2;
+        p->data = realloc(p->data, cap);
+        if (p->data == NULL) { perror("Unable to grow patch"); exit(1); }
+        p->data_cap = cap;
+    }
+    p->sites[p->count++] = (struct patch_site) { offset, length, p->len };
+    p->len += length;
+    return p->data + p->len - length;
+}
+
+// Decodes hex digit pairs, skipping whitespace. Returns the byte count, or
+// -1 on any other character or an odd number of digits.
+
+int64_t patch_hex(const char* text, size_t len, char* out) {
+    int64_t n = 0;
+    int high = -1;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = text[i];
+        if (isspace(c)) continue;
+        if (!isxdigit(c)) return -1;
+        int v = isdigit(c) ? c - '0' : tolower(c) - 'a' + 10;
+        if (high < 0) { high = v; continue; }
+        out[n++] = high << 4 | v;
+        high = -1;
+    }
+    return high < 0 ? n : -1;
+}
+
+static uint64_t be_read(const unsigned char* b, int n) {
+    uint64_t v = 0;
+    for (int i = 0; i < n; i++) v = v << 8 | b[i];
+    return v;
+}
+
+// IPS: "PATCH", then records of a 24-bit offset and a 16-bit size followed
+// by the bytes, or size 0 with a 16-bit count and one byte to repeat; "EOF"
+// ends the list and may be followed by a 24-bit length to truncate to.
+
+static bool parse_ips(struct patch* p, const unsigned char* b, size_t len) {
+    size_t i = 5;
+    while (true) {
+        if (i + 3 > len) return patch_fail(p, "IPS record cut short");
+        if (memcmp(b + i, "EOF", 3) == 0) {
+            if (i + 6 <= len) {
+                p->truncate = true;
+                p->truncate_at = be_read(b + i + 3, 3);
+            }
+            return true;
+        }
+        if (i + 5 > len) return patch_fail(p, "IPS record cut short");
+        uint64_t offset = be_read(b + i, 3);
+        uint64_t size = be_read(b + i + 3, 2);
+        i += 5;
+        if (size == 0) {
+            if (i + 3 > len) return patch_fail(p, "IPS run cut short");
+            uint64_t count = be_read(b + i, 2);
+            memset(patch_site(p, offset, count), b[i + 2], count);
+            i += 3;
+        } else {
+            if (i + size > len) return patch_fail(p, "IPS record cut short");
+            memcpy(patch_site(p, offset, size), b + i, size);
+            i += size;
+        }
+    }
+}
+
+// Listing: one "offset: hexbytes" site per line, offset in hex with an
+// optional 0x. Blank lines and text after '#' are ignored.
+
+static bool parse_listing(struct patch* p, const char* text, size_t len) {
+    const char* end = text + len;
+    for (const char* s = text; s < end; ) {
+        const char* eol = memchr(s, '\n', end - s);
+        if (eol == NULL) eol = end;
+        const char* hash = memchr(s, '#', eol - s);
+        const char* stop = hash ? hash : eol;
+        p->line++;
+
+        while (s < stop && isspace((unsigned char) *s)) s++;
+        if (s < stop) {
+            if (stop - s > 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) s += 2;
+            uint64_t offset = 0;
+            const char* digits = s;
+            while (s < stop && isxdigit((unsigned char) *s) && s - digits < 16) {
+                offset = offset << 4 | (isdigit((unsigned char) *s) ? *s - '0' : tolower((unsigned char) *s) - 'a' + 10);
+                s++;
+            }
+            if (s == digits || s == stop || *s != ':') return patch_fail(p, "expected `offset: hexbytes`");
+            s++;
+            char* bytes = patch_site(p, offset, (stop - s) / 2);
+            int64_t n = patch_hex(s, stop - s, bytes);
+            if (n <= 0) return patch_fail(p, n == 0 ? "no bytes" : "invalid hex bytes");
+            p->sites[p->count - 1].length = n;
+            p->len = p->sites[p->count - 1].at + n;
+        }
+        s = eol + 1;
+    }
+    if (p->count == 0) return patch_fail(p, "no patch sites");
+    p->line = 0;
+    return true;
+}
+
+bool patch_parse(struct patch* p, const char* text, size_t len) {
+    if (len >= 5 && memcmp(text, "PATCH", 5) == 0) return parse_ips(p, (const unsigned char*) text, len);
+    return parse_listing(p, text, len);
+}
+
+bool patch_load(struct patch* p, const char* path) {
+    FILE* fp = fopen(path, "rb");
+    if (fp == NULL) return patch_fail(p, strerror(errno));
+    char* text = NULL;
+    size_t len = 0, cap = 0, n;
+    do {
+        if (len == cap) {
+            cap = cap ? cap * 2 : 65536;
+            text = realloc(text, cap);
+            if (text == NULL) { perror("Unable to read patch"); exit(1); }
+        }
+        n = fread(text + len, 1, cap - len, fp);
+        len += n;
+    } while (n > 0);
+    bool ok = !ferror(fp) ? patch_parse(p, text, len) : patch_fail(p, strerror(errno));
+    fclose(fp);
+    free(text);
+    return ok;
+}
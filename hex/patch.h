@@ -0,0 +1,39 @@
+#ifndef XT_PATCH_H
+#define XT_PATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// A patch is a list of sites, each a run of bytes to put at an offset, read
+// from an IPS file or an "offset: hexbytes" listing. Site bytes share one
+// arena and the whole file is parsed before anything is applied.
+
+#define PATCH_GAP_MAX (1 << 24)   // how far past the end a site may start, as IPS
+
+struct patch_site {
+    uint64_t offset;
+    uint64_t length;
+    uint64_t at;       // position of the bytes in data
+};
+
+struct patch {
+    struct patch_site* sites;
+    size_t count;
+    size_t cap;
+    char* data;
+    uint64_t len;
+    uint64_t data_cap;
+    bool truncate;     // IPS truncation extension
+    uint64_t truncate_at;
+    uint32_t line;     // listing line of the error, 0 for IPS
+    const char* error;
+};
+
+void patch_init(struct patch* p);
+void patch_free(struct patch* p);
+bool patch_load(struct patch* p, const char* path);
+bool patch_parse(struct patch* p, const char* text, size_t len);
+int64_t patch_hex(const char* text, size_t len, char* out);
+
+#endif
@@ -0,0 +1,217 @@
+// BE: INFOSEC BINARY HEX EDITOR WITH DASM
+// Synrc Research (c) 2022-2025
+// 5HT DHARMA License
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "piece.h"
+
+// Takes a node from the free chain or the end of the pool. The pool may
+// move, so callers hold indices, not pointers, across this.
+
+static uint32_t piece_node(struct piece_table* t, uint64_t start, uint64_t length, bool add, uint32_t priority) {
+    uint32_t n = t->free;
+    if (n != 0) t->free = t->pieces[n].right;
+    else {
+        if (t->count == t->cap) {
+            size_t cap = t->cap ? t->cap * 2 : 16;
+            if (cap > UINT32_MAX) { fprintf(stderr, "Piece table full\n"); exit(1); }
+            t->pieces = realloc(t->pieces, cap * sizeof(struct piece));
+            if (t->pieces == NULL) { perror("Unable to grow piece table"); exit(1); }
+            t->cap = cap;
+        }
+        n = t->count++;
+    }
+    t->pieces[n] = (struct piece) { start, length, length, 0, 0, priority, add };
+    return n;
+}
+
+static uint32_t piece_priority(struct piece_table* t) {
+    t->seed ^= t->seed << 13;
+    t->seed ^= t->seed >> 17;
+    t->seed ^= t->seed << 5;
+    return t->seed;
+}
+
+static void piece_update(struct piece_table* t, uint32_t n) {
+    struct piece* p = &t->pieces[n];
+    p->total = t->pieces[p->left].total + p->length + t->pieces[p->right].total;
+}
+
+// Splits tree n into its first k bytes and the rest, cutting the piece
+// that straddles k in two. The cut-off half keeps the priority of the
+// piece it came from, so the heap order holds.
+
+static void piece_split(struct piece_table* t, uint32_t n, uint64_t k, uint32_t* l, uint32_t* r) {
+    if (n == 0) { *l = *r = 0; return; }
+    uint64_t before = t->pieces[t->pieces[n].left].total;
+    uint64_t length = t->pieces[n].length;
+    if (k <= before) {
+        uint32_t left;
+        piece_split(t, t->pieces[n].left, k, l, &left);
+        t->pieces[n].left = left;
+        *r = n;
+    } else if (k >= before + length) {
+        uint32_t right;
+        piece_split(t, t->pieces[n].right, k - before - length, &right, r);
+        t->pieces[n].right = right;
+        *l = n;
+    } else {
+        uint64_t keep = k - before;
+        struct piece p = t->pieces[n];
+        uint32_t m = piece_node(t, p.start + keep, p.length - keep, p.add, p.priority);
+        t->pieces[m].right = p.right;
+        piece_update(t, m);
+        t->pieces[n].length = keep;
+        t->pieces[n].right = 0;
+        *l = n;
+        *r = m;
+    }
+    piece_update(t, n);
+}
+
+static uint32_t piece_merge(struct piece_table* t, uint32_t a, uint32_t b) {
+    if (a == 0) return b;
+    if (b == 0) return a;
+    if (t->pieces[a].priority >= t->pieces[b].priority) {
+        uint32_t right = piece_merge(t, t->pieces[a].right, b);
+        t->pieces[a].right = right;
+        piece_update(t, a);
+        return a;
+    }
+    uint32_t left = piece_merge(t, a, t->pieces[b].left);
+    t->pieces[b].left = left;
+    piece_update(t, b);
+    return b;
+}
+
+static void piece_release(struct piece_table* t, uint32_t n) {
+    if (n == 0) return;
+    piece_release(t, t->pieces[n].left);
+    piece_release(t, t->pieces[n].right);
+    t->pieces[n].right = t->free;
+    t->free = n;
+}
+
+static uint64_t piece_append(struct piece_table* t, const char* data, uint64_t length) {
+    if (t->add_length + length > t->add_cap) {
+        uint64_t cap = t->add_cap ? t->add_cap * 2 : 4096;
+        while (cap < t->add_length + length) cap *= 2;
+        t->add = realloc(t->add, cap);
+        if (t->add == NULL) { perror("Unable to grow add buffer"); exit(1); }
+        t->add_cap = cap;
+    }
+    uint64_t at = t->add_length;
+    memcpy(t->add + at, data, length);
+    t->add_length += length;
+    return at;
+}
+
+void piece_init(struct piece_table* t, char* orig, uint64_t length) {
+    memset(t, 0, sizeof(*t));
+    t->orig = orig;
+    t->orig_length = length;
+    t->length = length;
+    t->seed = 2463534242u;
+    piece_node(t, 0, 0, false, 0);
+    if (length != 0) t->root = piece_node(t, 0, length, false, piece_priority(t));
+}
+
+void piece_free(struct piece_table* t) {
+    free(t->add);
+    free(t->pieces);
+    t->add = NULL;
+    t->pieces = NULL;
+    t->count = t->cap = 0;
+    t->root = t->free = 0;
+    t->add_length = t->add_cap = 0;
+}
+
+char* piece_at(const struct piece_table* t, uint64_t offset, uint64_t* run) {
+    uint32_t n = t->root;
+    while (true) {
+        const struct piece* p = &t->pieces[n];
+        uint64_t before = t->pieces[p->left].total;
+        if (offset < before) n = p->left;
+        else if (offset - before < p->length) {
+            uint64_t skip = offset - before;
+            *run = p->length - skip;
+            return (p->add ? t->add : t->orig) + p->start + skip;
+        } else {
+            offset -= before + p->length;
+            n = p->right;
+        }
+    }
+}
+
+void piece_read(const struct piece_table* t, uint64_t offset, char* dst, uint64_t length) {
+    uint64_t run;
+    while (length > 0 && offset < t->length) {
+        char* src = piece_at(t, offset, &run);
+        if (run > length) run = length;
+        memcpy(dst, src, run);
+        dst += run; offset += run; length -= run;
+    }
+    memset(dst, 0, length);
+}
+
+// Contiguous view of [offset, offset + length): points into the buffer when a
+// single piece covers it, otherwise the bytes are copied to scratch and the
+// part past the end is zero filled.
+
+const char* piece_span(const struct piece_table* t, uint64_t offset, uint64_t length, char* scratch) {
+    uint64_t run;
+    if (offset < t->length) {
+        char* ptr = piece_at(t, offset, &run);
+        if (run >= length) return ptr;
+    }
+    piece_read(t, offset, scratch, length);
+    return scratch;
+}
+
+void piece_write(struct piece_table* t, uint64_t offset, const char* src, uint64_t length) {
+    uint64_t run;
+    while (length > 0 && offset < t->length) {
+        char* dst = piece_at(t, offset, &run);
+        if (run > length) run = length;
+        memcpy(dst, src, run);
+        src += run; offset += run; length -= run;
+    }
+}
+
+// A run typed right after the previous one extends its piece instead of
+// adding a node: the rightmost piece before the cut, found down the right
+// spine, with every total on the way grown by length.
+
+static bool piece_extend(struct piece_table* t, uint32_t n, uint64_t at, uint64_t length) {
+    uint32_t last = n;
+    while (last != 0 && t->pieces[last].right != 0) last = t->pieces[last].right;
+    if (last == 0 || !t->pieces[last].add || t->pieces[last].start + t->pieces[last].length != at) return false;
+    t->pieces[last].length += length;
+    for (; n != 0; n = t->pieces[n].right) t->pieces[n].total += length;
+    return true;
+}
+
+void piece_insert(struct piece_table* t, uint64_t offset, const char* data, uint64_t length) {
+    uint32_t l, r;
+    if (length == 0) return;
+    if (offset > t->length) offset = t->length;
+    uint64_t at = piece_append(t, data, length);
+    piece_split(t, t->root, offset, &l, &r);
+    if (!piece_extend(t, l, at, length)) l = piece_merge(t, l, piece_node(t, at, length, true, piece_priority(t)));
+    t->root = piece_merge(t, l, r);
+    t->length += length;
+}
+
+void piece_erase(struct piece_table* t, uint64_t offset, uint64_t length) {
+    uint32_t l, m, r;
+    if (offset >= t->length || length == 0) return;
+    if (length > t->length - offset) length = t->length - offset;
+    piece_split(t, t->root, offset, &l, &r);
+    piece_split(t, r, length, &m, &r);
+    piece_release(t, m);
+    t->root = piece_merge(t, l, r);
+    t->length -= length;
+}
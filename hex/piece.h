@@ -0,0 +1,47 @@
+#ifndef XT_PIECE_H
+#define XT_PIECE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+// Piece table: the file is the concatenation of pieces, each one a run of
+// either the original buffer or the append-only add buffer. Pieces are the
+// nodes of a treap in file order, each keeping the length of its subtree,
+// so lookups, inserts and erases take O(log pieces) expected.
+
+struct piece {
+    uint64_t start;    // position inside the source buffer
+    uint64_t length;
+    uint64_t total;    // bytes in this subtree
+    uint32_t left;     // node indices, 0 is none
+    uint32_t right;
+    uint32_t priority;
+    bool add;          // source is the add buffer
+};
+
+struct piece_table {
+    char* orig;
+    uint64_t orig_length;
+    char* add;
+    uint64_t add_length;
+    uint64_t add_cap;
+    struct piece* pieces;   // node pool; pieces[0] is the empty tree
+    size_t count;           // nodes handed out, free ones included
+    size_t cap;
+    uint32_t root;
+    uint32_t free;          // free nodes, chained through right
+    uint32_t seed;
+    uint64_t length;
+};
+
+void piece_init(struct piece_table* t, char* orig, uint64_t length);
+void piece_free(struct piece_table* t);
+char* piece_at(const struct piece_table* t, uint64_t offset, uint64_t* run);
+const char* piece_span(const struct piece_table* t, uint64_t offset, uint64_t length, char* scratch);
+void piece_read(const struct piece_table* t, uint64_t offset, char* dst, uint64_t length);
+void piece_write(struct piece_table* t, uint64_t offset, const char* src, uint64_t length);
+void piece_insert(struct piece_table* t, uint64_t offset, const char* data, uint64_t length);
+void piece_erase(struct piece_table* t, uint64_t offset, uint64_t length);
+
+#endif
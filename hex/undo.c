@@ -0,0 +1,166 @@
+// BE: INFOSEC BINARY HEX EDITOR WITH DASM
+// Synrc Research (c) 2022-2025
+// 5HT DHARMA License
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "undo.h"
+
+static void undo_grow(char** buf, uint64_t* cap, uint64_t need) {
+    if (need <= *cap) return;
+    uint64_t size = *cap ? *cap * 2 : 4096;
+    while (size < need) size *= 2;
+    *buf = realloc(*buf, size);
+    if (*buf == NULL) { perror("Unable to grow undo journal"); exit(1); }
+    *cap = size;
+}
+
+static void undo_clear(struct undo_journal* j) {
+    j->count = j->pos = 0;
+    j->old_len = j->new_len = 0;
+    j->open = false;
+}
+
+// Drops the oldest step and compacts both arenas behind it.
+
+static void undo_drop(struct undo_journal* j) {
+    size_t n = 0;
+    uint32_t step = j->records[0].step;
+    while (n < j->count && j->records[n].step == step) n++;
+
+    uint64_t old_cut = n < j->count ? j->records[n].old_at : j->old_len;
+    uint64_t new_cut = n < j->count ? j->records[n].new_at : j->new_len;
+    memmove(j->old, j->old + old_cut, j->old_len - old_cut);
+    memmove(j->new, j->new + new_cut, j->new_len - new_cut);
+    j->old_len -= old_cut;
+    j->new_len -= new_cut;
+
+    memmove(j->records, j->records + n, (j->count - n) * sizeof(struct undo_record));
+    j->count -= n;
+    j->pos = j->pos > n ? j->pos - n : 0;
+    for (size_t i = 0; i < j->count; i++) {
+        j->records[i].old_at -= old_cut;
+        j->records[i].new_at -= new_cut;
+    }
+    if (j->count == 0) j->open = false;
+}
+
+void undo_init(struct undo_journal* j, uint64_t limit) {
+    memset(j, 0, sizeof(*j));
+    j->limit = limit;
+}
+
+void undo_free(struct undo_journal* j) {
+    free(j->records);
+    free(j->old);
+    free(j->new);
+    memset(j, 0, sizeof(*j));
+}
+
+void undo_seal(struct undo_journal* j) {
+    j->open = false;
+}
+
+void undo_begin(struct undo_journal* j) {
+    j->open = false;
+    j->group = true;
+    j->lost = false;
+    j->step++;
+}
+
+// Closes the group; false when it outgrew the limit and was not recorded.
+
+bool undo_end(struct undo_journal* j) {
+    j->open = false;
+    j->group = false;
+    return !j->lost;
+}
+
+// Reserves room for an edit of length bytes at offset. *old and *new point
+// to where the caller copies the bytes before and after the edit (NULL when
+// the kind has no such side). Returns false when the edit alone, or the open
+// group with it, exceeds the limit; the history is then discarded since it
+// can no longer be replayed, and the rest of the group is not recorded.
+// Steps of the open group are never dropped to make room, so undo never
+// restores half of one.
+
+bool undo_push(struct undo_journal* j, enum undo_kind kind, uint64_t offset, uint64_t length, char** old, char** new) {
+    uint64_t old_need = kind != UNDO_INSERT ? length : 0;
+    uint64_t new_need = kind != UNDO_DELETE ? length : 0;
+    *old = *new = NULL;
+    if (j->group && j->lost) return false;
+
+    if (j->pos < j->count) {
+        j->old_len = j->records[j->pos].old_at;
+        j->new_len = j->records[j->pos].new_at;
+        j->count = j->pos;
+        j->open = false;
+    }
+
+    if (j->old_len + j->new_len + old_need + new_need > j->limit)
+        while (j->count > 0 && !(j->group && j->records[0].step == j->step) &&
+               j->old_len + j->new_len + old_need + new_need > j->limit / 2) undo_drop(j);
+
+    if (j->old_len + j->new_len + old_need + new_need > j->limit) {
+        undo_clear(j);
+        j->lost = j->group;
+        return false;
+    }
+
+    struct undo_record* last = j->count ? &j->records[j->count - 1] : NULL;
+    undo_grow(&j->old, &j->old_cap, j->old_len + old_need);
+    undo_grow(&j->new, &j->new_cap, j->new_len + new_need);
+
+    if (j->open && last && last->kind == kind && kind != UNDO_DELETE && last->offset + last->length == offset) {
+        last->length += length;
+    } else {
+        if (j->count == j->cap) {
+            j->cap = j->cap ? j->cap * 2 : 64;
+            j->records = realloc(j->records, j->cap * sizeof(struct undo_record));
+            if (j->records == NULL) { perror("Unable to grow undo journal"); exit(1); }
+        }
+        j->records[j->count++] = (struct undo_record) { kind, j->group ? j->step : ++j->step, offset, length, j->old_len, j->new_len };
+    }
+
+    if (old_need) *old = j->old + j->old_len;
+    if (new_need) *new = j->new + j->new_len;
+    j->old_len += old_need;
+    j->new_len += new_need;
+    j->pos = j->count;
+    j->open = kind != UNDO_DELETE;
+    return true;
+}
+
+size_t undo_count(const struct undo_journal* j, bool redo) {
+    size_t n = 0;
+    if (redo) {
+        if (j->pos == j->count) return 0;
+        uint32_t step = j->records[j->pos].step;
+        while (j->pos + n < j->count && j->records[j->pos + n].step == step) n++;
+    } else {
+        if (j->pos == 0) return 0;
+        uint32_t step = j->records[j->pos - 1].step;
+        while (n < j->pos && j->records[j->pos - 1 - n].step == step) n++;
+    }
+    return n;
+}
+
+struct undo_record* undo_back(struct undo_journal* j) {
+    j->open = false;
+    return &j->records[--j->pos];
+}
+
+struct undo_record* undo_forward(struct undo_journal* j) {
+    j->open = false;
+    return &j->records[j->pos++];
+}
+
+const char* undo_old(const struct undo_journal* j, const struct undo_record* r) {
+    return j->old + r->old_at;
+}
+
+const char* undo_new(const struct undo_journal* j, const struct undo_record* r) {
+    return j->new + r->new_at;
+}
@@ -0,0 +1,61 @@
+#ifndef XT_UNDO_H
+#define XT_UNDO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#define UNDO_LIMIT (64 << 20)
+
+// Undo journal: records hold only the touched bytes, kept in two
+// append-only arenas (bytes before and after the edit). Contiguous
+// replacements or inserts extend the open record instead of adding one.
+// Records pushed between undo_begin and undo_end share one step and are
+// undone together.
+
+enum undo_kind {
+    UNDO_REPLACE,
+    UNDO_INSERT,
+    UNDO_DELETE,
+};
+
+struct undo_record {
+    enum undo_kind kind;
+    uint32_t step;
+    uint64_t offset;
+    uint64_t length;
+    uint64_t old_at;
+    uint64_t new_at;
+};
+
+struct undo_journal {
+    struct undo_record* records;
+    size_t count;
+    size_t cap;
+    size_t pos;
+    char* old;
+    uint64_t old_len;
+    uint64_t old_cap;
+    char* new;
+    uint64_t new_len;
+    uint64_t new_cap;
+    uint64_t limit;
+    uint32_t step;
+    bool open;
+    bool group;
+    bool lost;       // the open group outgrew the limit
+};
+
+void undo_init(struct undo_journal* j, uint64_t limit);
+void undo_free(struct undo_journal* j);
+void undo_seal(struct undo_journal* j);
+void undo_begin(struct undo_journal* j);
+bool undo_end(struct undo_journal* j);
+bool undo_push(struct undo_journal* j, enum undo_kind kind, uint64_t offset, uint64_t length, char** old, char** new);
+size_t undo_count(const struct undo_journal* j, bool redo);
+struct undo_record* undo_back(struct undo_journal* j);
+struct undo_record* undo_forward(struct undo_journal* j);
+const char* undo_old(const struct undo_journal* j, const struct undo_record* r);
+const char* undo_new(const struct undo_journal* j, const struct undo_record* r);
+
+#endif
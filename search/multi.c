@@ -0,0 +1,262 @@
+// BE: INFOSEC BINARY HEX EDITOR WITH DASM
+// Synrc Research (c) 2022-2025
+// 5HT DHARMA License
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "multi.h"
+#include "pool.h"
+
+static size_t key_length(const struct search_pattern* p) {
+    return p->len < SEARCH_KEY_MAX ? p->len : SEARCH_KEY_MAX;
+}
+
+static uint32_t set_state(struct search_set* s) {
+    if (s->states == s->states_cap) {
+        s->states_cap = s->states_cap ? s->states_cap * 2 : 256;
+        s->next = realloc(s->next, s->states_cap * sizeof(*s->next));
+        s->out = realloc(s->out, s->states_cap * sizeof(int32_t));
+        if (s->next == NULL || s->out == NULL) { perror("Unable to grow search automaton"); exit(1); }
+    }
+    memset(s->next[s->states], 0, sizeof(*s->next));
+    s->out[s->states] = -1;
+    return s->states++;
+}
+
+void search_set_init(struct search_set* s) {
+    memset(s, 0, sizeof(*s));
+}
+
+// Takes ownership of a compiled pattern; patterns with no literal byte have
+// nothing to put in the automaton and are refused.
+
+bool search_set_add(struct search_set* s, struct search_pattern* p, uint32_t line) {
+    if (p->algo == ALGO_MASK) return false;
+    if (s->count == s->cap) {
+        s->cap = s->cap ? s->cap * 2 : 64;
+        s->patterns = realloc(s->patterns, s->cap * sizeof(struct search_pattern));
+        s->lines = realloc(s->lines, s->cap * sizeof(uint32_t));
+        if (s->patterns == NULL || s->lines == NULL) { perror("Unable to grow pattern set"); exit(1); }
+    }
+    s->patterns[s->count] = *p;
+    s->lines[s->count] = line;
+    s->count++;
+    return true;
+}
+
+void search_set_build(struct search_set* s) {
+    s->states = 0;
+    set_state(s);
+    s->back = s->ahead = s->keymax = 0;
+
+    s->out_next = malloc(s->count * sizeof(int32_t));
+    if (s->count && s->out_next == NULL) { perror("Unable to build search automaton"); exit(1); }
+    for (size_t i = 0; i < s->count; i++) {
+        const struct search_pattern* p = &s->patterns[i];
+        size_t k = key_length(p);
+        uint32_t state = 0;
+        for (size_t j = 0; j < k; j++) {
+            if (s->next[state][p->bytes[j]] == 0) {
+                uint32_t fresh = set_state(s);
+                s->next[state][p->bytes[j]] = fresh;
+            }
+            state = s->next[state][p->bytes[j]];
+        }
+        s->out_next[i] = s->out[state];
+        s->out[state] = i;
+        if (k > s->keymax) s->keymax = k;
+        if (p->anchor + k > s->back) s->back = p->anchor + k;
+        if (p->max_len > s->ahead) s->ahead = p->max_len;
+    }
+
+    // Breadth first: fail links, dictionary links to the nearest suffix state
+    // with output, and missing edges filled from the fail state.
+
+    s->fail = calloc(s->states, sizeof(uint32_t));
+    s->dict = calloc(s->states, sizeof(uint32_t));
+    uint32_t* queue = malloc(s->states * sizeof(uint32_t));
+    if (s->fail == NULL || s->dict == NULL || queue == NULL) { perror("Unable to build search automaton"); exit(1); }
+    size_t head = 0, tail = 0;
+    for (int c = 0; c < 256; c++)
+        if (s->next[0][c]) queue[tail++] = s->next[0][c];
+    while (head < tail) {
+        uint32_t state = queue[head++];
+        uint32_t f = s->fail[state];
+        s->dict[state] = s->out[f] >= 0 ? f : s->dict[f];
+        for (int c = 0; c < 256; c++) {
+            uint32_t child = s->next[state][c];
+            if (child) {
+                s->fail[child] = s->next[f][c];
+                queue[tail++] = child;
+            } else {
+                s->next[state][c] = s->next[f][c];
+            }
+        }
+    }
+    free(queue);
+
+    // Edges into states with output carry SEARCH_EMIT, so the scan loop
+    // tests one bit per byte.
+
+    for (size_t state = 0; state < s->states; state++)
+        for (int c = 0; c < 256; c++) {
+            uint32_t t = s->next[state][c];
+            if (s->out[t] >= 0 || s->dict[t]) s->next[state][c] = t | SEARCH_EMIT;
+        }
+}
+
+void search_set_release(struct search_set* s) {
+    for (size_t i = 0; i < s->count; i++) search_release(&s->patterns[i]);
+    free(s->patterns);
+    free(s->lines);
+    free(s->next);
+    free(s->fail);
+    free(s->dict);
+    free(s->out);
+    free(s->out_next);
+    search_set_init(s);
+}
+
+static void hit_push(struct search_hits* h, uint64_t offset, uint32_t pattern) {
+    if (h->count == h->cap) {
+        h->cap = h->cap ? h->cap * 2 : 256;
+        h->hits = realloc(h->hits, h->cap * sizeof(struct search_hit));
+        if (h->hits == NULL) { perror("Unable to grow hit list"); exit(1); }
+    }
+    h->hits[h->count++] = (struct search_hit) { offset, pattern };
+}
+
+static int hit_compare(const void* a, const void* b) {
+    const struct search_hit* x = a;
+    const struct search_hit* y = b;
+    if (x->offset != y->offset) return x->offset < y->offset ? -1 : 1;
+    return x->pattern < y->pattern ? -1 : x->pattern > y->pattern;
+}
+
+// A full list keeps the first SEARCH_HITS_MAX hits by offset. A chunk's
+// hits start at most back bytes before it, so once the chunks up to c
+// hold that many, only chunk c + 1 can still add earlier ones: cut is set
+// to it and later chunks are skipped.
+
+struct set_scan {
+    struct editor* e;
+    const struct search_set* set;
+    struct search_hits* chunks;
+    bool* done;
+    char** scratch;
+    pthread_mutex_t lock;
+    size_t ready;            // chunks before this one are all done
+    size_t total;            // hits in those chunks
+    atomic_size_t cut;       // last chunk that still counts, polled by every worker
+    atomic_bool truncated;
+};
+
+static bool set_scan_past(struct set_scan* x, size_t task) {
+    if (task <= atomic_load_explicit(&x->cut, memory_order_acquire)) return false;
+    atomic_store_explicit(&x->truncated, true, memory_order_relaxed);
+    return true;
+}
+
+// Marks a chunk done and moves the cut once the done prefix is full.
+
+static void set_scan_finish(struct set_scan* x, size_t task, size_t tasks) {
+    pthread_mutex_lock(&x->lock);
+    x->done[task] = true;
+    for (; x->ready < tasks && x->done[x->ready]; x->ready++) {
+        x->total += x->chunks[x->ready].count;
+        if (x->total >= SEARCH_HITS_MAX && atomic_load_explicit(&x->cut, memory_order_relaxed) == SIZE_MAX)
+            atomic_store_explicit(&x->cut, x->ready + 1, memory_order_release);
+    }
+    pthread_mutex_unlock(&x->lock);
+}
+
+// Runs on a pool thread. The automaton restarts keymax - 1 bytes before the
+// chunk, which is enough to see every keyword ending inside it; the window
+// also holds back bytes before and ahead bytes after the chunk to verify.
+// A chunk that alone fills the list stops back bytes later, past which no
+// hit can start before the ones it has.
+
+static void set_scan_chunk(void* arg, size_t task, size_t worker) {
+    struct set_scan* x = arg;
+    const struct search_set* s = x->set;
+    struct search_hits* h = &x->chunks[task];
+    uint64_t length = x->e->content_length;
+    uint64_t start = (uint64_t) task * SEARCH_CHUNK;
+    uint64_t count = length - start < SEARCH_CHUNK ? length - start : SEARCH_CHUNK;
+    size_t tasks = (length + SEARCH_CHUNK - 1) / SEARCH_CHUNK;
+    if (set_scan_past(x, task)) return;
+
+    if (x->scratch[worker] == NULL) {
+        x->scratch[worker] = malloc(SEARCH_CHUNK + s->back + s->ahead);
+        if (x->scratch[worker] == NULL) { perror("Unable to allocate search window"); exit(1); }
+    }
+    uint64_t from = start > s->back ? start - s->back : 0;
+    uint64_t to = start + count + s->ahead;
+    if (to > length) to = length;
+    const unsigned char* data = (const unsigned char*) editor_span(x->e, from, to - from, x->scratch[worker]);
+    uint32_t (*next)[256] = s->next;
+
+    uint32_t state = 0;
+    for (uint64_t i = start > s->keymax - 1 ? start - (s->keymax - 1) : 0; i < start; i++)
+        state = next[state][data[i - from]] & ~SEARCH_EMIT;
+
+    uint64_t stop = start + count;
+    for (uint64_t i = start; i < stop; i++) {
+        state = next[state][data[i - from]];
+        if (!(state & SEARCH_EMIT)) continue;
+        state &= ~SEARCH_EMIT;
+        for (uint32_t t = s->out[state] >= 0 ? state : s->dict[state]; t != 0; t = s->dict[t]) {
+            for (int32_t k = s->out[t]; k >= 0; k = s->out_next[k]) {
+                const struct search_pattern* p = &s->patterns[k];
+                uint64_t lead = key_length(p) + p->anchor;
+                if (i + 1 < lead) continue;
+                uint64_t at = i + 1 - lead;
+                if (!search_match(p, (const char*) data, to - from, at - from)) continue;
+                hit_push(h, at, s->lines[k]);
+                if (h->count == SEARCH_HITS_MAX && i + s->back < stop) {
+                    stop = i + s->back;
+                    atomic_store_explicit(&x->truncated, true, memory_order_relaxed);
+                }
+                if (h->count % SEARCH_HITS_BATCH == 0 && set_scan_past(x, task)) stop = i;
+            }
+        }
+    }
+    set_scan_finish(x, task, tasks);
+}
+
+// Replaces the editor hit list with every match of the set, ordered by
+// offset. Chunks are scanned on the pool and their lists merged. Returns
+// false when the list was cut at SEARCH_HITS_MAX.
+
+bool search_set_scan(struct editor* e, const struct search_set* s) {
+    e->hit_count = 0;
+    e->hit_pos = 0;
+    if (s->count == 0 || e->content_length == 0) return true;
+
+    size_t tasks = (e->content_length + SEARCH_CHUNK - 1) / SEARCH_CHUNK;
+    struct set_scan x = { e, s, calloc(tasks, sizeof(struct search_hits)), calloc(tasks, sizeof(bool)),
+                          calloc(pool_size(), sizeof(char*)), PTHREAD_MUTEX_INITIALIZER, 0, 0, SIZE_MAX, false };
+    if (x.chunks == NULL || x.done == NULL || x.scratch == NULL) { perror("Unable to allocate search job"); exit(1); }
+    pool_run(tasks, set_scan_chunk, &x);
+
+    struct search_hits all = { e->hits, 0, e->hit_cap };
+    for (size_t i = 0; i < tasks; i++) {
+        for (size_t k = 0; k < x.chunks[i].count; k++) hit_push(&all, x.chunks[i].hits[k].offset, x.chunks[i].hits[k].pattern);
+        free(x.chunks[i].hits);
+    }
+    for (size_t i = 0; i < pool_size(); i++) free(x.scratch[i]);
+    free(x.scratch);
+    free(x.chunks);
+    free(x.done);
+    pthread_mutex_destroy(&x.lock);
+
+    qsort(all.hits, all.count, sizeof(struct search_hit), hit_compare);
+    e->hits = all.hits;
+    e->hit_cap = all.cap;
+    e->hit_count = all.count < SEARCH_HITS_MAX ? all.count : SEARCH_HITS_MAX;
+    return all.count <= SEARCH_HITS_MAX && !atomic_load(&x.truncated);
+}
@@ -0,0 +1,51 @@
+#ifndef XT_MULTI_H
+#define XT_MULTI_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "search.h"
+
+#define SEARCH_KEY_MAX 32
+#define SEARCH_HITS_MAX (1 << 20)
+#define SEARCH_HITS_BATCH 4096
+#define SEARCH_EMIT (1u << 31)
+
+// Aho-Corasick over the anchors of a set of compiled patterns. Each anchor
+// (cut to SEARCH_KEY_MAX bytes) is a keyword of a dense DFA, so the file is
+// read once whatever the number of patterns; a keyword hit is mapped back to
+// its pattern start and verified like a single search. Chunks of the file
+// are scanned in parallel on the pool.
+
+struct search_set {
+    struct search_pattern* patterns;
+    uint32_t* lines;
+    size_t count;
+    size_t cap;
+
+    uint32_t (*next)[256];
+    uint32_t* fail;
+    uint32_t* dict;
+    int32_t* out;
+    int32_t* out_next;
+    size_t states;
+    size_t states_cap;
+    size_t keymax;
+    size_t back;
+    size_t ahead;
+};
+
+struct search_hits {
+    struct search_hit* hits;
+    size_t count;
+    size_t cap;
+};
+
+void search_set_init(struct search_set* s);
+bool search_set_add(struct search_set* s, struct search_pattern* p, uint32_t line);
+void search_set_build(struct search_set* s);
+void search_set_release(struct search_set* s);
+bool search_set_scan(struct editor* e, const struct search_set* s);
+
+#endif
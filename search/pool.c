@@ -0,0 +1,76 @@
+// BE: INFOSEC BINARY HEX EDITOR WITH DASM
+// Synrc Research (c) 2022-2025
+// 5HT DHARMA License
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "pool.h"
+
+static struct {
+    pthread_once_t once;
+    pthread_mutex_t run;
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    pthread_cond_t idle;
+    size_t size;
+    pool_task fn;
+    void* arg;
+    size_t tasks;
+    size_t next;
+    size_t done;
+} pool = { PTHREAD_ONCE_INIT, PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+           PTHREAD_COND_INITIALIZER, PTHREAD_COND_INITIALIZER, 0, NULL, NULL, 0, 0, 0 };
+
+static void* pool_main(void* arg) {
+    size_t worker = (size_t) arg;
+    pthread_mutex_lock(&pool.lock);
+    while (true) {
+        while (pool.next >= pool.tasks) pthread_cond_wait(&pool.work, &pool.lock);
+        size_t task = pool.next++;
+        pool_task fn = pool.fn;
+        void* fn_arg = pool.arg;
+        pthread_mutex_unlock(&pool.lock);
+        fn(fn_arg, task, worker);
+        pthread_mutex_lock(&pool.lock);
+        if (++pool.done == pool.tasks) pthread_cond_signal(&pool.idle);
+    }
+    return NULL;
+}
+
+static void pool_start() {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    pool.size = cores < 1 ? 1 : cores > POOL_MAX ? POOL_MAX : (size_t) cores;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    for (size_t i = 0; i < pool.size; i++) {
+        pthread_t thread;
+        if (pthread_create(&thread, &attr, pool_main, (void*) i) != 0) { perror("Unable to start worker thread"); exit(1); }
+    }
+    pthread_attr_destroy(&attr);
+}
+
+size_t pool_size() {
+    pthread_once(&pool.once, pool_start);
+    return pool.size;
+}
+
+void pool_run(size_t tasks, pool_task fn, void* arg) {
+    if (tasks == 0) return;
+    pool_size();
+    pthread_mutex_lock(&pool.run);
+    pthread_mutex_lock(&pool.lock);
+    pool.fn = fn;
+    pool.arg = arg;
+    pool.next = pool.done = 0;
+    pool.tasks = tasks;
+    pthread_cond_broadcast(&pool.work);
+    while (pool.done < pool.tasks) pthread_cond_wait(&pool.idle, &pool.lock);
+    pool.tasks = pool.next = 0;
+    pthread_mutex_unlock(&pool.lock);
+    pthread_mutex_unlock(&pool.run);
+}
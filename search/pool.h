@@ -0,0 +1,17 @@
+#ifndef XT_POOL_H
+#define XT_POOL_H
+
+#include <stddef.h>
+
+#define POOL_MAX 256
+
+// Process-wide pool with one thread per online core, started on first use.
+// pool_run hands out task indices in increasing order and returns once all
+// of them are done; runs from different threads are serialized.
+
+typedef void (*pool_task)(void* arg, size_t task, size_t worker);
+
+size_t pool_size();
+void pool_run(size_t tasks, pool_task fn, void* arg);
+
+#endif
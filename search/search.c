@@ -0,0 +1,267 @@
+// BE: INFOSEC BINARY HEX EDITOR WITH DASM
+// Synrc Research (c) 2022-2025
+// 5HT DHARMA License
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "search.h"
+
+static const unsigned char* search_memrchr(const unsigned char* s, int c, size_t n) {
+#ifdef __GLIBC__
+    return memrchr(s, c, n);
+#else
+    while (n-- > 0) if (s[n] == (unsigned char) c) return s + n;
+    return NULL;
+#endif
+}
+
+void search_init(struct search_pattern* p) {
+    memset(p, 0, sizeof(*p));
+}
+
+void search_add_byte(struct search_pattern* p, unsigned char value, unsigned char mask) {
+    if (p->count == p->cap) {
+        p->cap = p->cap ? p->cap * 2 : 64;
+        p->values = realloc(p->values, p->cap);
+        p->masks = realloc(p->masks, p->cap);
+        if (p->values == NULL || p->masks == NULL) { perror("Unable to grow search pattern"); exit(1); }
+    }
+    if (p->segcount == 0) {
+        p->segments = malloc(sizeof(struct search_segment));
+        if (p->segments == NULL) { perror("Unable to grow search pattern"); exit(1); }
+        p->segments[p->segcount++] = (struct search_segment) { 0, 0, 0, 0 };
+    }
+    p->values[p->count] = value & mask;
+    p->masks[p->count] = mask;
+    p->segments[p->segcount - 1].len++;
+    p->count++;
+    if (mask != 0xFF) p->masked = true;
+}
+
+// A fixed gap is just that many wildcard atoms; only a variable gap starts a
+// new segment, so the first segment is everything at a fixed match offset.
+
+bool search_add_gap(struct search_pattern* p, size_t min, size_t max) {
+    if (p->count == 0 || min > max || max > SEARCH_GAP_MAX) return false;
+    if (min == max) {
+        for (size_t i = 0; i < min; i++) search_add_byte(p, 0, 0);
+        return true;
+    }
+    p->segments = realloc(p->segments, (p->segcount + 1) * sizeof(struct search_segment));
+    if (p->segments == NULL) { perror("Unable to grow search pattern"); exit(1); }
+    p->segments[p->segcount++] = (struct search_segment) { p->count, 0, min, max };
+    p->masked = true;
+    return true;
+}
+
+bool search_compile(struct search_pattern* p) {
+    if (p->count == 0 || p->segments[0].len == 0 || p->segments[p->segcount - 1].len == 0) return false;
+
+    p->min_len = p->max_len = 0;
+    for (size_t i = 0; i < p->segcount; i++) {
+        p->min_len += p->segments[i].gap_min + p->segments[i].len;
+        p->max_len += p->segments[i].gap_max + p->segments[i].len;
+    }
+
+    size_t best = 0, best_len = 0;
+    for (size_t i = 0; i < p->segments[0].len; ) {
+        size_t j = i;
+        while (j < p->segments[0].len && p->masks[j] == 0xFF) j++;
+        if (j - i > best_len) { best = i; best_len = j - i; }
+        i = j + 1;
+    }
+
+    p->anchor = best;
+    p->bytes = p->values + best;
+    p->len = best_len;
+    if (best_len == 0) { p->algo = ALGO_MASK; return true; }
+    p->algo = best_len < SEARCH_SHORT ? ALGO_MEMCHR : ALGO_BMH;
+
+    for (int c = 0; c < 256; c++) p->skip[c] = p->rskip[c] = best_len;
+    for (size_t i = 0; i + 1 < best_len; i++) p->skip[p->bytes[i]] = best_len - 1 - i;
+    for (size_t i = best_len - 1; i > 0; i--) p->rskip[p->bytes[i]] = i;
+    return true;
+}
+
+void search_release(struct search_pattern* p) {
+    free(p->values);
+    free(p->masks);
+    free(p->segments);
+    search_init(p);
+}
+
+static bool match_atoms(const struct search_pattern* p, const unsigned char* h, const struct search_segment* s) {
+    for (size_t i = 0; i < s->len; i++)
+        if ((h[i] & p->masks[s->first + i]) != p->values[s->first + i]) return false;
+    return true;
+}
+
+// Later segments are matched over the set of positions a gap can reach
+// from the end of the one before, a segment at a time, so the cost is the
+// window times the segment lengths however many gaps there are. Sets fit
+// on the stack up to MATCH_STACK positions.
+
+#define MATCH_STACK 4096
+
+static bool match_from(const struct search_pattern* p, const unsigned char* hay, size_t len, size_t at) {
+    const struct search_segment* s = &p->segments[0];
+    if (at + s->len > len || !match_atoms(p, hay + at, s)) return false;
+    if (p->segcount == 1) return true;
+
+    size_t w = p->max_len < len - at ? p->max_len + 1 : len - at + 1;
+    unsigned char stack[2 * MATCH_STACK], *reach = stack;
+    if (w > MATCH_STACK && (reach = malloc(2 * w)) == NULL) { perror("Unable to match search pattern"); exit(1); }
+    unsigned char *ends = reach, *next = reach + w, *t;
+    memset(ends, 0, w);
+    ends[s->len] = 1;
+
+    bool found = false;
+    for (size_t k = 1; k < p->segcount; k++, t = ends, ends = next, next = t) {
+        s = &p->segments[k];
+        memset(next, 0, w);
+        found = false;
+        size_t last = SIZE_MAX;   // latest end a gap of at least gap_min leaves behind q
+        for (size_t q = s->gap_min; q + s->len < w; q++) {
+            if (ends[q - s->gap_min]) last = q - s->gap_min;
+            if (last == SIZE_MAX || last + s->gap_max < q) continue;
+            if (match_atoms(p, hay + at + q, s)) {
+                next[q + s->len] = 1;
+                found = true;
+                if (k + 1 == p->segcount) break;
+            }
+        }
+        if (!found) break;
+    }
+    if (reach != stack) free(reach);
+    return found;
+}
+
+bool search_match(const struct search_pattern* p, const char* hay, size_t len, size_t at) {
+    return match_from(p, (const unsigned char*) hay, len, at);
+}
+
+static const unsigned char* scan_memchr(const struct search_pattern* p, const unsigned char* hay, size_t len) {
+    const unsigned char* h = hay;
+    const unsigned char* end = hay + len - p->len + 1;
+    while (h < end) {
+        h = memchr(h, p->bytes[0], end - h);
+        if (h == NULL) return NULL;
+        if (memcmp(h + 1, p->bytes + 1, p->len - 1) == 0) return h;
+        h++;
+    }
+    return NULL;
+}
+
+static const unsigned char* scan_memchr_reverse(const struct search_pattern* p, const unsigned char* hay, size_t len) {
+    size_t n = len - p->len + 1;
+    while (n > 0) {
+        const unsigned char* h = search_memrchr(hay, p->bytes[0], n);
+        if (h == NULL) return NULL;
+        if (memcmp(h + 1, p->bytes + 1, p->len - 1) == 0) return h;
+        n = h - hay;
+    }
+    return NULL;
+}
+
+static const unsigned char* scan_bmh(const struct search_pattern* p, const unsigned char* hay, size_t len) {
+    size_t last = p->len - 1;
+    unsigned char tail = p->bytes[last];
+    for (size_t i = 0; i + p->len <= len; ) {
+        unsigned char c = hay[i + last];
+        if (c == tail && memcmp(hay + i, p->bytes, last) == 0) return hay + i;
+        i += p->skip[c];
+    }
+    return NULL;
+}
+
+static const unsigned char* scan_bmh_reverse(const struct search_pattern* p, const unsigned char* hay, size_t len) {
+    unsigned char head = p->bytes[0];
+    for (size_t i = len - p->len + 1; i-- > 0; ) {
+        unsigned char c = hay[i];
+        if (c == head && memcmp(hay + i + 1, p->bytes + 1, p->len - 1) == 0) return hay + i;
+        size_t step = p->rskip[c];
+        if (step > i) break;
+        i -= step - 1;
+    }
+    return NULL;
+}
+
+static const unsigned char* scan_anchor(const struct search_pattern* p, const unsigned char* h, size_t len, enum search_direction dir) {
+    if (len < p->len) return NULL;
+    switch (p->algo) {
+        case ALGO_MEMCHR: return dir == SEARCH_FORWARD ? scan_memchr(p, h, len) : scan_memchr_reverse(p, h, len);
+        case ALGO_BMH:    return dir == SEARCH_FORWARD ? scan_bmh(p, h, len) : scan_bmh_reverse(p, h, len);
+        default:          return NULL;
+    }
+}
+
+// Returns the first (or last) match in hay[0, len) whose start is below
+// starts. Anchor hits are mapped back to a match start and verified.
+
+const char* search_scan(const struct search_pattern* p, const char* hay, size_t len, size_t starts, enum search_direction dir) {
+    const unsigned char* h = (const unsigned char*) hay;
+    if (len < p->min_len) return NULL;
+    if (starts > len - p->min_len + 1) starts = len - p->min_len + 1;
+    if (starts == 0) return NULL;
+
+    if (p->algo == ALGO_MASK) {
+        for (size_t i = 0; i < starts; i++) {
+            size_t at = dir == SEARCH_FORWARD ? i : starts - 1 - i;
+            if (match_from(p, h, len, at)) return hay + at;
+        }
+        return NULL;
+    }
+
+    const unsigned char* base = h + p->anchor;
+    size_t lo = 0, hi = starts - 1 + p->len;
+    if (hi > len - p->anchor) hi = len - p->anchor;
+    while (lo < hi) {
+        const unsigned char* m = scan_anchor(p, base + lo, hi - lo, dir);
+        if (m == NULL) return NULL;
+        size_t at = m - base;
+        if (!p->masked || match_from(p, h, len, at)) return hay + at;
+        if (dir == SEARCH_FORWARD) lo = at + 1; else hi = at + p->len - 1;
+    }
+    return NULL;
+}
+
+// Finds the match starting in [from, to) closest to from (forward) or to
+// (backward). The range is walked in SEARCH_CHUNK windows that overlap by
+// max_len - 1 bytes; a window inside one piece is scanned in place.
+
+bool search_find(struct editor* e, const struct search_pattern* p, uint64_t from, uint64_t to, enum search_direction dir, uint64_t* found) {
+    if (to > e->content_length) to = e->content_length;
+    if (from >= to || p->min_len > e->content_length) return false;
+
+    char* scratch = malloc(SEARCH_CHUNK + p->max_len);
+    if (scratch == NULL) { perror("Unable to allocate search window"); exit(1); }
+
+    bool hit = false;
+    uint64_t lo = dir == SEARCH_FORWARD ? from : to;
+    while (!hit && (dir == SEARCH_FORWARD ? lo < to : lo > from)) {
+        uint64_t start, count;
+        if (dir == SEARCH_FORWARD) {
+            start = lo;
+            count = to - lo < SEARCH_CHUNK ? to - lo : SEARCH_CHUNK;
+            lo += count;
+        } else {
+            count = lo - from < SEARCH_CHUNK ? lo - from : SEARCH_CHUNK;
+            start = lo -= count;
+        }
+
+        uint64_t n = count + p->max_len - 1;
+        if (n > e->content_length - start) n = e->content_length - start;
+        const char* data = editor_span(e, start, n, scratch);
+        const char* m = search_scan(p, data, n, count, dir);
+        if (m != NULL) {
+            *found = start + (m - data);
+            hit = true;
+        }
+    }
+
+    free(scratch);
+    return hit;
+}
@@ -0,0 +1,60 @@
+#ifndef XT_SEARCH_H
+#define XT_SEARCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "../editor.h"
+
+#define SEARCH_SHORT 16
+#define SEARCH_CHUNK (4 << 20)
+#define SEARCH_GAP_MAX 4096
+
+enum search_algo {
+    ALGO_MEMCHR,   // short anchors: vectorized libc scan for the first byte, then memcmp
+    ALGO_BMH,      // long anchors: Boyer-Moore-Horspool, mirrored for backward scans
+    ALGO_MASK,     // no literal byte to anchor on: verify the masks at every offset
+};
+
+// A pattern is a list of (value, mask) atoms split into segments by
+// variable gaps. The longest fully literal run of the first segment is the
+// anchor handed to the scanner; every anchor hit is then verified against
+// the masks and gaps. Plain strings are one unmasked segment.
+
+struct search_segment {
+    size_t first;
+    size_t len;
+    size_t gap_min;
+    size_t gap_max;
+};
+
+struct search_pattern {
+    unsigned char* values;
+    unsigned char* masks;
+    size_t count;
+    size_t cap;
+    struct search_segment* segments;
+    size_t segcount;
+    bool masked;
+    size_t min_len;
+    size_t max_len;
+
+    enum search_algo algo;
+    const unsigned char* bytes;
+    size_t len;
+    size_t anchor;
+    size_t skip[256];
+    size_t rskip[256];
+};
+
+void search_init(struct search_pattern* p);
+void search_add_byte(struct search_pattern* p, unsigned char value, unsigned char mask);
+bool search_add_gap(struct search_pattern* p, size_t min, size_t max);
+bool search_compile(struct search_pattern* p);
+void search_release(struct search_pattern* p);
+bool search_match(const struct search_pattern* p, const char* hay, size_t len, size_t at);
+const char* search_scan(const struct search_pattern* p, const char* hay, size_t len, size_t starts, enum search_direction dir);
+bool search_find(struct editor* e, const struct search_pattern* p, uint64_t from, uint64_t to, enum search_direction dir, uint64_t* found);
+
+#endif
@@ -0,0 +1,151 @@
+// BE: INFOSEC BINARY HEX EDITOR WITH DASM
+// Synrc Research (c) 2022-2025
+// 5HT DHARMA License
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "pool.h"
+#include "worker.h"
+#include "../term/event.h"
+
+static uint64_t clock_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void job_chunks(struct search_job* j, uint64_t from, uint64_t to, enum search_direction dir) {
+    uint64_t lo = dir == SEARCH_FORWARD ? from : to;
+    while (dir == SEARCH_FORWARD ? lo < to : lo > from) {
+        struct search_chunk c = { 0 };
+        if (dir == SEARCH_FORWARD) {
+            c.start = lo;
+            c.count = to - lo < SEARCH_CHUNK ? to - lo : SEARCH_CHUNK;
+            lo += c.count;
+        } else {
+            c.count = lo - from < SEARCH_CHUNK ? lo - from : SEARCH_CHUNK;
+            c.start = lo -= c.count;
+        }
+        c.dir = dir;
+        j->chunks[j->count++] = c;
+    }
+}
+
+// Runs on a pool thread: counts every match starting in the chunk and keeps
+// the one nearest to the cursor. Chunks overlap by max_len - 1 bytes.
+
+static void job_chunk(void* arg, size_t task, size_t worker) {
+    struct search_job* j = arg;
+    struct search_chunk* c = &j->chunks[task];
+    const struct search_pattern* p = &j->pattern;
+    if (atomic_load_explicit(&j->cancel, memory_order_acquire)) return;
+
+    if (j->scratch[worker] == NULL) {
+        j->scratch[worker] = malloc(SEARCH_CHUNK + p->max_len);
+        if (j->scratch[worker] == NULL) { perror("Unable to allocate search window"); exit(1); }
+    }
+
+    uint64_t n = c->count + p->max_len - 1;
+    if (n > j->length - c->start) n = j->length - c->start;
+    const char* data = editor_span(j->e, c->start, n, j->scratch[worker]);
+    bool found = false;
+    uint64_t first = 0, hits = 0;
+    for (size_t a = 0; a < c->count; ) {
+        const char* m = search_scan(p, data + a, n - a, c->count - a, SEARCH_FORWARD);
+        if (m == NULL) break;
+        a = m - data;
+        if (!found || c->dir == SEARCH_BACKWARD) first = c->start + a;
+        found = true;
+        hits++;
+        a++;
+    }
+
+    // Results are merged in walk order: the first match is only published
+    // once every chunk nearer to the cursor is done and has none.
+
+    pthread_mutex_lock(&j->lock);
+    c->found = found;
+    c->first = first;
+    c->done = true;
+    j->progress.hits += hits;
+    j->progress.done += c->count;
+    bool wake = false;
+    while (j->ready < j->count && j->chunks[j->ready].done) {
+        struct search_chunk* r = &j->chunks[j->ready++];
+        if (r->found && !j->progress.found) {
+            j->progress.found = true;
+            j->progress.first = r->first;
+            wake = true;
+        }
+    }
+    uint64_t now = clock_ms();
+    if (now - j->woken >= SEARCH_TICK_MS) wake = true;
+    if (wake) j->woken = now;
+    pthread_mutex_unlock(&j->lock);
+    if (wake) event_wake();
+}
+
+static void* job_main(void* arg) {
+    struct search_job* j = arg;
+    pool_run(j->count, job_chunk, j);
+    pthread_mutex_lock(&j->lock);
+    j->progress.running = false;
+    pthread_mutex_unlock(&j->lock);
+    event_wake();
+    return NULL;
+}
+
+// Takes ownership of a compiled pattern. Forward jobs look for the first
+// match at or after from, backward jobs for the last one before it. Chunks
+// are laid out from the cursor in the search direction, then wrap around
+// from the other end of the file, and the pool picks them up in that order.
+
+struct search_job* search_job_start(struct editor* e, struct search_pattern* p, enum search_direction dir, uint64_t from) {
+    struct search_job* j = calloc(1, sizeof(struct search_job));
+    if (j == NULL) { perror("Unable to allocate search job"); exit(1); }
+    pthread_mutex_init(&j->lock, NULL);
+    atomic_init(&j->cancel, false);
+    j->e = e;
+    j->pattern = *p;
+    j->length = e->content_length;
+    if (from > j->length) from = j->length;
+
+    j->chunks = malloc((j->length / SEARCH_CHUNK + 2) * sizeof(struct search_chunk));
+    j->scratch = calloc(pool_size(), sizeof(char*));
+    if (j->chunks == NULL || j->scratch == NULL) { perror("Unable to allocate search job"); exit(1); }
+    if (dir == SEARCH_FORWARD) {
+        job_chunks(j, from, j->length, SEARCH_FORWARD);
+        job_chunks(j, 0, from, SEARCH_FORWARD);
+    } else {
+        job_chunks(j, 0, from, SEARCH_BACKWARD);
+        job_chunks(j, from, j->length, SEARCH_BACKWARD);
+    }
+
+    j->progress.running = true;
+    j->progress.total = j->length;
+    j->woken = clock_ms();
+    if (pthread_create(&j->thread, NULL, job_main, j) != 0) { perror("Unable to start search thread"); exit(1); }
+    return j;
+}
+
+void search_job_progress(struct search_job* j, struct search_progress* out) {
+    pthread_mutex_lock(&j->lock);
+    *out = j->progress;
+    pthread_mutex_unlock(&j->lock);
+}
+
+// Joins the job, stopping it first when cancel is set, and frees it.
+
+void search_job_finish(struct search_job* j, bool cancel) {
+    if (cancel) atomic_store_explicit(&j->cancel, true, memory_order_release);
+    pthread_join(j->thread, NULL);
+    pthread_mutex_destroy(&j->lock);
+    for (size_t i = 0; i < pool_size(); i++) free(j->scratch[i]);
+    free(j->scratch);
+    free(j->chunks);
+    search_release(&j->pattern);
+    free(j);
+}
@@ -0,0 +1,58 @@
+#ifndef XT_WORKER_H
+#define XT_WORKER_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "search.h"
+
+#define SEARCH_TICK_MS 100
+
+// A search running in the background. The file is cut into SEARCH_CHUNK
+// chunks scanned on the thread pool; the nearest match is published as soon
+// as the chunks before it are done, while the rest of the file is still
+// being counted. The job wakes the main loop when the match is published,
+// when it ends and at most every SEARCH_TICK_MS with progress; the editor
+// cancels it before touching the buffer.
+
+struct search_progress {
+    bool running;
+    bool found;
+    uint64_t first;
+    uint64_t hits;
+    uint64_t done;
+    uint64_t total;
+};
+
+struct search_chunk {
+    uint64_t start;
+    uint64_t count;
+    enum search_direction dir;
+    bool done;
+    bool found;
+    uint64_t first;
+};
+
+struct search_job {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    atomic_bool cancel;   // set by the editor, polled by the pool threads
+    struct editor* e;
+    struct search_pattern pattern;
+    uint64_t length;
+    struct search_chunk* chunks;
+    size_t count;
+    size_t ready;
+    char** scratch;
+    struct search_progress progress;
+    uint64_t woken;
+    bool shown;   // main thread only: first match already jumped to
+};
+
+struct search_job* search_job_start(struct editor* e, struct search_pattern* p, enum search_direction dir, uint64_t from);
+void search_job_progress(struct search_job* j, struct search_progress* out);
+void search_job_finish(struct search_job* j, bool cancel);
+
+#endif
@@ -1,5 +1,6 @@
 #include <assert.h>
 #include <errno.h>
+#include <poll.h>
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -52,11 +53,42 @@ int charbuf_appendf(struct charbuf* buf, const char* fmt, ...) {
     return len;
 }
 
+void charbuf_reset(struct charbuf* buf) {
+    buf->len = 0;
+}
+
+void charbuf_reserve(struct charbuf* buf, size_t cap) {
+    if ((int) cap <= buf->cap) return;
+    buf->contents = realloc(buf->contents, cap);
+    if (buf->contents == NULL) { perror("Unable to realloc charbuf"); exit(1); }
+    buf->cap = cap;
+}
+
+// Writes everything, resuming after short writes and EINTR; a non-blocking
+// descriptor that fills up is waited on with poll.
+
+int write_all(int fd, const char* data, size_t len) {
+    while (len > 0) {
+        ssize_t bw = write(fd, data, len);
+        if (bw < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                struct pollfd p = { fd, POLLOUT, 0 };
+                poll(&p, 1, -1);
+                continue;
+            }
+            return -1;
+        }
+        data += bw;
+        len -= bw;
+    }
+    return 0;
+}
+
 void charbuf_draw(struct charbuf* buf) {
-    if (write(STDOUT_FILENO, buf->contents, buf->len) == -1) {
+    if (write_all(STDOUT_FILENO, buf->contents, buf->len) == -1) {
         perror("Can't write charbuf");
         exit(1);
-
     }
 }
 
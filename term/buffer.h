@@ -3,6 +3,9 @@
 
 #include <stdlib.h> // size_t
 
+// Frames are built in a charbuf that lives for the whole session: reset
+// keeps the allocation, so a steady-state repaint does not touch malloc.
+
 static const unsigned int CHARBUF_APPENDF_SIZE = 1024;
 struct charbuf { char* contents; int len; int cap; };
 
@@ -10,6 +13,9 @@ struct charbuf* charbuf_create();
 void charbuf_free(struct charbuf* buf);
 void charbuf_append(struct charbuf* buf, const char* what, size_t len);
 int charbuf_appendf(struct charbuf* buf, const char* what, ...);
+void charbuf_reset(struct charbuf* buf);
+void charbuf_reserve(struct charbuf* buf, size_t cap);
 void charbuf_draw(struct charbuf* buf);
+int  write_all(int fd, const char* data, size_t len);
 
 #endif // HX_CHARBUF_H
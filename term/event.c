@@ -0,0 +1,50 @@
+// BE: INFOSEC BINARY HEX EDITOR WITH DASM
+// Synrc Research (c) 2022-2025
+// 5HT DHARMA License
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "event.h"
+#include "terminal.h"
+
+static int wake_pipe[2] = { -1, -1 };
+
+void event_init() {
+    if (pipe(wake_pipe) != 0) { perror("Unable to create wake pipe"); exit(1); }
+    for (int i = 0; i < 2; i++) {
+        fcntl(wake_pipe[i], F_SETFL, fcntl(wake_pipe[i], F_GETFL) | O_NONBLOCK);
+        fcntl(wake_pipe[i], F_SETFD, FD_CLOEXEC);
+    }
+}
+
+// Async-signal-safe. A full pipe already holds a pending wakeup.
+
+void event_wake() {
+    int saved = errno;
+    if (wake_pipe[1] != -1) (void) (write(wake_pipe[1], "", 1) + 1);
+    errno = saved;
+}
+
+// Waits up to timeout_ms (-1 forever) and returns the events that are
+// ready; 0 on timeout. Keys already buffered count without polling.
+
+int event_wait(int timeout_ms) {
+    if (key_pending(0)) return EVENT_KEY;
+    struct pollfd fds[2] = { { STDIN_FILENO, POLLIN, 0 }, { wake_pipe[0], POLLIN, 0 } };
+    if (poll(fds, 2, timeout_ms) <= 0) return 0;
+
+    int events = 0;
+    if (fds[0].revents & (POLLIN | POLLHUP)) events |= EVENT_KEY;
+    if (fds[1].revents & POLLIN) {
+        char drain[64];
+        while (read(wake_pipe[0], drain, sizeof(drain)) > 0) ;
+        events |= EVENT_WAKE;
+    }
+    return events;
+}
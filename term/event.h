@@ -0,0 +1,17 @@
+#ifndef XT_EVENT_H
+#define XT_EVENT_H
+
+// Wakeups for the main loop. Signal handlers and worker threads write a
+// byte to a self-pipe that is polled together with stdin, so the loop
+// sleeps until there is a key, a resize or a result to show.
+
+enum event_kind {
+    EVENT_KEY  = 1 << 0,
+    EVENT_WAKE = 1 << 1,
+};
+
+void event_init();
+void event_wake();
+int  event_wait(int timeout_ms);
+
+#endif
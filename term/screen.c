@@ -0,0 +1,292 @@
+// BE: INFOSEC BINARY HEX EDITOR WITH DASM
+// Synrc Research (c) 2022-2025
+// 5HT DHARMA License
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "buffer.h"
+#include "screen.h"
+
+struct grid {
+    struct cell* cells;
+    int row;
+    int col;
+    bool wrap;      // cursor sits past the last column until the next glyph
+    bool visible;
+    struct cell_attr attr;
+};
+
+static struct grid front;   // what the terminal shows
+static struct grid back;    // front with the new frame applied; the cursor
+                            // and SGR state carry over from the last frame
+static int screen_rows;
+static int screen_cols;
+static bool screen_known;   // false until the terminal is in a known state
+static struct charbuf* out; // reused for every frame
+
+static const struct cell blank = { " ", 1, { COLOR_DEFAULT, COLOR_DEFAULT, 0 } };
+
+static bool attr_equal(struct cell_attr a, struct cell_attr b) {
+    return a.fg == b.fg && a.bg == b.bg && a.flags == b.flags;
+}
+
+static bool cell_equal(const struct cell* a, const struct cell* b) {
+    return a->len == b->len && memcmp(a->glyph, b->glyph, a->len) == 0 && attr_equal(a->attr, b->attr);
+}
+
+static void grid_fill(struct grid* g, int from, int to, struct cell_attr attr) {
+    struct cell c = blank;
+    c.attr.bg = attr.bg;
+    for (int i = from; i < to; i++) g->cells[i] = c;
+}
+
+static void grid_reset(struct grid* g) {
+    grid_fill(g, 0, screen_rows * screen_cols, blank.attr);
+    g->row = g->col = 0;
+    g->wrap = false;
+    g->visible = true;
+    g->attr = blank.attr;
+}
+
+static void grid_linefeed(struct grid* g) {
+    if (g->row + 1 < screen_rows) { g->row++; return; }
+    memmove(g->cells, g->cells + screen_cols, (size_t) (screen_rows - 1) * screen_cols * sizeof(struct cell));
+    grid_fill(g, (screen_rows - 1) * screen_cols, screen_rows * screen_cols, g->attr);
+}
+
+static void grid_put(struct grid* g, const char* glyph, int len) {
+    if (g->wrap) {
+        g->col = 0;
+        g->wrap = false;
+        grid_linefeed(g);
+    }
+    struct cell* c = &g->cells[g->row * screen_cols + g->col];
+    memcpy(c->glyph, glyph, len);
+    c->len = len;
+    c->attr = g->attr;
+    if (g->col + 1 < screen_cols) g->col++; else g->wrap = true;
+}
+
+static uint32_t sgr_color(const int* p, int n, int* i) {
+    if (*i + 2 < n && p[*i + 1] == 5) { *i += 2; return COLOR_INDEX | (p[*i] & 0xFF); }
+    if (*i + 4 < n && p[*i + 1] == 2) {
+        *i += 4;
+        return COLOR_RGB | (p[*i - 2] & 0xFF) << 16 | (p[*i - 1] & 0xFF) << 8 | (p[*i] & 0xFF);
+    }
+    return COLOR_DEFAULT;
+}
+
+static void grid_sgr(struct grid* g, const int* p, int n) {
+    struct cell_attr* a = &g->attr;
+    if (n == 0) { *a = blank.attr; return; }
+    for (int i = 0; i < n; i++) {
+        int v = p[i];
+        if (v == 0) *a = blank.attr;
+        else if (v == 1) a->flags |= CELL_BOLD;
+        else if (v == 2) a->flags |= CELL_DIM;
+        else if (v == 3) a->flags |= CELL_ITALIC;
+        else if (v == 4) a->flags |= CELL_UNDERLINE;
+        else if (v == 5) a->flags |= CELL_BLINK;
+        else if (v == 7) a->flags |= CELL_REVERSE;
+        else if (v == 22) a->flags &= ~(CELL_BOLD | CELL_DIM);
+        else if (v == 23) a->flags &= ~CELL_ITALIC;
+        else if (v == 24) a->flags &= ~CELL_UNDERLINE;
+        else if (v == 25) a->flags &= ~CELL_BLINK;
+        else if (v == 27) a->flags &= ~CELL_REVERSE;
+        else if (v >= 30 && v <= 37) a->fg = COLOR_INDEX | (v - 30);
+        else if (v == 38) a->fg = sgr_color(p, n, &i);
+        else if (v == 39) a->fg = COLOR_DEFAULT;
+        else if (v >= 40 && v <= 47) a->bg = COLOR_INDEX | (v - 40);
+        else if (v == 48) a->bg = sgr_color(p, n, &i);
+        else if (v == 49) a->bg = COLOR_DEFAULT;
+        else if (v >= 90 && v <= 97) a->fg = COLOR_INDEX | (v - 90 + 8);
+        else if (v >= 100 && v <= 107) a->bg = COLOR_INDEX | (v - 100 + 8);
+    }
+}
+
+static void grid_csi(struct grid* g, char final, bool private, const int* p, int n) {
+    int row_base = g->row * screen_cols;
+    switch (final) {
+        case 'm': grid_sgr(g, p, n); break;
+        case 'H':
+        case 'f':
+            g->row = (n > 0 && p[0] > 0 ? p[0] : 1) - 1;
+            g->col = (n > 1 && p[1] > 0 ? p[1] : 1) - 1;
+            if (g->row >= screen_rows) g->row = screen_rows - 1;
+            if (g->col >= screen_cols) g->col = screen_cols - 1;
+            g->wrap = false;
+            break;
+        case 'C':
+            g->col += n > 0 && p[0] > 0 ? p[0] : 1;
+            if (g->col >= screen_cols) g->col = screen_cols - 1;
+            g->wrap = false;
+            break;
+        case 'K':
+            switch (n > 0 ? p[0] : 0) {
+                case 0: grid_fill(g, row_base + g->col, row_base + screen_cols, g->attr); break;
+                case 1: grid_fill(g, row_base, row_base + g->col + 1, g->attr); break;
+                case 2: grid_fill(g, row_base, row_base + screen_cols, g->attr); break;
+            }
+            break;
+        case 'J':
+            switch (n > 0 ? p[0] : 0) {
+                case 0: grid_fill(g, row_base + g->col, screen_rows * screen_cols, g->attr); break;
+                case 1: grid_fill(g, 0, row_base + g->col + 1, g->attr); break;
+                case 2:
+                case 3: grid_fill(g, 0, screen_rows * screen_cols, g->attr); break;
+            }
+            break;
+        case 'h':
+        case 'l':
+            if (private && n > 0 && p[0] == 25) g->visible = final == 'h';
+            break;
+    }
+}
+
+// Applies the subset of VT100/xterm the renderers emit: glyphs (UTF-8 as one
+// cell), CR, LF, CUP, CUF, EL, ED, SGR and cursor visibility.
+
+static void grid_apply(struct grid* g, const char* s, size_t len) {
+    size_t i = 0;
+    while (i < len) {
+        unsigned char c = s[i];
+        if (c == 0x1b && i + 1 < len && s[i + 1] == '[') {
+            int p[16], n = 0, v = 0;
+            bool digits = false, private = false;
+            i += 2;
+            if (i < len && s[i] == '?') { private = true; i++; }
+            while (i < len && ((s[i] >= '0' && s[i] <= '9') || s[i] == ';')) {
+                if (s[i] == ';') { if (n < 16) p[n++] = v; v = 0; digits = false; }
+                else { v = v * 10 + (s[i] - '0'); digits = true; }
+                i++;
+            }
+            if (digits || n > 0) { if (n < 16) p[n++] = v; }
+            if (i < len) grid_csi(g, s[i++], private, p, n);
+        } else if (c == 0x1b) {
+            i += 2;
+        } else if (c == '\r') {
+            g->col = 0; g->wrap = false; i++;
+        } else if (c == '\n') {
+            g->col = 0; g->wrap = false; grid_linefeed(g); i++;   // ONLCR
+        } else if (c < 0x20 || c == 0x7f) {
+            i++;
+        } else {
+            int n = c < 0x80 ? 1 : c >= 0xf0 ? 4 : c >= 0xe0 ? 3 : c >= 0xc0 ? 2 : 1;
+            if (i + n > len) n = len - i;
+            grid_put(g, s + i, n);
+            i += n;
+        }
+    }
+}
+
+static int sgr_color_code(char* s, uint32_t color, int base) {
+    if (color == COLOR_DEFAULT) return sprintf(s, ";%d", base + 9);
+    if (color & COLOR_RGB) return sprintf(s, ";%d;2;%d;%d;%d", base + 8, color >> 16 & 0xFF, color >> 8 & 0xFF, color & 0xFF);
+    if ((color & 0xFF) < 8) return sprintf(s, ";%d", base + (color & 0xFF));
+    if ((color & 0xFF) < 16) return sprintf(s, ";%d", base + 60 + (color & 0xFF) - 8);
+    return sprintf(s, ";%d;5;%d", base + 8, color & 0xFF);
+}
+
+// Moves the terminal attributes from cur to want: only the changed colors
+// when no flag has to be cleared, otherwise a reset and the full set.
+
+static void sgr_emit(struct charbuf* b, struct cell_attr cur, struct cell_attr want) {
+    static const int codes[] = { 1, 2, 3, 4, 5, 7 };
+    bool reset = (cur.flags & ~want.flags) != 0;
+    if (reset) cur = blank.attr;
+    char s[64] = "\x1b[";
+    int n = 1;
+    if (reset) n += sprintf(s + n, ";0");
+    for (int i = 0; i < 6; i++)
+        if ((want.flags & ~cur.flags) & (1 << i)) n += sprintf(s + n, ";%d", codes[i]);
+    if (want.fg != cur.fg && !(reset && want.fg == COLOR_DEFAULT)) n += sgr_color_code(s + n, want.fg, 30);
+    if (want.bg != cur.bg && !(reset && want.bg == COLOR_DEFAULT)) n += sgr_color_code(s + n, want.bg, 40);
+    s[1] = '[';
+    s[n++] = 'm';
+    charbuf_append(b, s, n);
+}
+
+static void cursor_emit(struct charbuf* b, int row, int col) {
+    if (front.row == row && !front.wrap && col > front.col && col - front.col <= 4) {
+        if (col - front.col == 1) charbuf_append(b, "\x1b[C", 3);
+        else charbuf_appendf(b, "\x1b[%dC", col - front.col);
+    } else if (row == front.row && col == 0) {
+        charbuf_append(b, "\r", 1);
+    } else if (row == front.row + 1 && col == 0) {
+        charbuf_append(b, "\r\n", 2);
+    } else {
+        charbuf_appendf(b, "\x1b[%d;%dH", row + 1, col + 1);
+    }
+    front.row = row;
+    front.col = col;
+    front.wrap = false;
+}
+
+static void screen_resize(int rows, int cols) {
+    size_t size = (size_t) rows * cols * sizeof(struct cell);
+    front.cells = realloc(front.cells, size);
+    back.cells = realloc(back.cells, size);
+    if (front.cells == NULL || back.cells == NULL) { perror("Unable to allocate screen"); exit(1); }
+    screen_rows = rows;
+    screen_cols = cols;
+    screen_known = false;
+    if (out == NULL) out = charbuf_create();
+    charbuf_reserve(out, size);
+}
+
+// The terminal was cleared behind our back (clear_screen): it is now blank
+// with default attributes and the cursor home.
+
+void screen_invalidate() {
+    if (front.cells == NULL) return;
+    grid_reset(&front);
+    memcpy(back.cells, front.cells, (size_t) screen_rows * screen_cols * sizeof(struct cell));
+    screen_known = true;
+}
+
+void screen_draw(const char* frame, size_t len, int rows, int cols) {
+    if (rows <= 0 || cols <= 0) return;
+    if (rows != screen_rows || cols != screen_cols) screen_resize(rows, cols);
+
+    struct charbuf* b = out;
+    charbuf_reset(b);
+    if (!screen_known) {
+        charbuf_append(b, "\x1b[0m\x1b[H\x1b[2J", 11);
+        grid_reset(&front);
+        grid_reset(&back);
+        screen_known = true;
+    }
+
+    memcpy(back.cells, front.cells, (size_t) rows * cols * sizeof(struct cell));
+    grid_apply(&back, frame, len);
+
+    bool hidden = false;
+    for (int row = 0; row < rows; row++) {
+        for (int col = 0; col < cols; col++) {
+            const struct cell* want = &back.cells[row * cols + col];
+            struct cell* have = &front.cells[row * cols + col];
+            if (cell_equal(want, have)) continue;
+            if (!hidden && front.visible) { charbuf_append(b, "\x1b[?25l", 6); front.visible = false; }
+            hidden = true;
+            if (front.wrap || row != front.row || col != front.col) cursor_emit(b, row, col);
+            if (!attr_equal(front.attr, want->attr)) sgr_emit(b, front.attr, want->attr);
+            charbuf_append(b, want->glyph, want->len);
+            front.attr = want->attr;
+            *have = *want;
+            if (col + 1 < cols) front.col++; else front.wrap = true;
+        }
+    }
+
+    if (back.visible) {
+        if (front.wrap || front.row != back.row || front.col != back.col) cursor_emit(b, back.row, back.col);
+        if (!front.visible) charbuf_append(b, "\x1b[?25h", 6);
+        front.visible = true;
+    } else if (front.visible) {
+        charbuf_append(b, "\x1b[?25l", 6);
+        front.visible = false;
+    }
+
+    if (b->len > 0) charbuf_draw(b);
+}
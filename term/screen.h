@@ -0,0 +1,41 @@
+#ifndef XT_SCREEN_H
+#define XT_SCREEN_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Shadow screen. A composed frame is interpreted into a cell grid (glyph
+// plus attributes) on top of the previous one, like the terminal would,
+// and only the cells that differ from what is on the terminal are sent,
+// with short cursor moves and SGR changes.
+
+enum cell_flags {
+    CELL_BOLD      = 1 << 0,
+    CELL_DIM       = 1 << 1,
+    CELL_ITALIC    = 1 << 2,
+    CELL_UNDERLINE = 1 << 3,
+    CELL_BLINK     = 1 << 4,
+    CELL_REVERSE   = 1 << 5,
+};
+
+#define COLOR_DEFAULT 0
+#define COLOR_INDEX   0x100      // | 0..255
+#define COLOR_RGB     0x1000000  // | 0xRRGGBB
+
+struct cell_attr {
+    uint32_t fg;
+    uint32_t bg;
+    uint8_t flags;
+};
+
+struct cell {
+    char glyph[4];
+    uint8_t len;
+    struct cell_attr attr;
+};
+
+void screen_draw(const char* frame, size_t len, int rows, int cols);
+void screen_invalidate();
+
+#endif
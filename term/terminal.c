@@ -1,5 +1,7 @@
+#define _GNU_SOURCE
 #include <ctype.h>
 #include <errno.h>
+#include <poll.h>
 #include <inttypes.h>
 #include <stdbool.h>
 #include <stdint.h>
@@ -10,6 +12,8 @@
 #include <termios.h>
 #include <unistd.h>
 
+#include "buffer.h"
+#include "screen.h"
 #include "terminal.h"
 
 static struct termios orig_termios;
@@ -46,6 +50,14 @@ int hex2int(const char* s) {
     return x;
 }
 
+uint64_t hex2u64(const char* s) {
+    char* endptr;
+    errno = 0;
+    uintmax_t x = strtoumax(s, &endptr, 16);
+    if (errno == ERANGE) return 0;
+    return x;
+}
+
 inline int clampi(int i, int min, int max) {
     if (i < min) return min;
     if (i > max) return max;
@@ -61,91 +73,213 @@ int str2int(const char* s, int min, int max, int def) {
     return x;
 }
 
-int read_key() {
-    int c = getchar();
-    if (c == 27) { // Esc або стрілки
-        int c2 = getchar();
-        if (c2 == '[') {
-            int c3 = getchar();
-            if (c3 == 'A') return KEY_UP;    // Up
-            if (c3 == 'B') return KEY_DOWN;  // Down
-            if (c3 == 'C') return KEY_RIGHT; // Right
-            if (c3 == 'D') return KEY_LEFT;  // Left
-            if (c3 == 'H') return KEY_HOME;  // Home
-            if (c3 == 'F') return KEY_END;   // End
-            if (c3 == '3' && getchar() == '~') return KEY_DELETE;
-            if (c3 == '5') { // PgUp
-                getchar(); // ~
-                return KEY_PGUP;
-            }
-            if (c3 == '6') { // PgDown
-                getchar(); // ~
-                return KEY_PGDOWN;
-            } else if (c3 == '1' && getchar() == ';') { // Ctrl/Shift modifiers
-                int c5 = getchar();
-                if (c5 == '5') { // Ctrl
-                    int c6 = getchar();
-                    if (c6 == 'D') return KEY_CTRL_LEFT;  // Ctrl+Left: \033[1;5D
-                    if (c6 == 'C') return KEY_CTRL_RIGHT; // Ctrl+Right: \033[1;5C
-                } else if (c5 == '2') { // Shift
-                    int c6 = getchar();
-                    if (c6 == 'D') return KEY_SHIFT_LEFT;  // Shift+Left: \033[1;2D
-                    if (c6 == 'C') return KEY_SHIFT_RIGHT; // Shift+Right: \033[1;2C
-                }
-            }
-            // Обробка F1-F10
-            if (c3 >= '1' && c3 <= '2') {
-                int c4 = getchar();
-                if (c3 == '1') {
-                    if (c4 == '1') { getchar(); return KEY_F1; }  // F1: \033[11~
-                    if (c4 == '2') { getchar(); return KEY_F2; }  // F2: \033[12~
-                    if (c4 == '3') { getchar(); return KEY_F3; }  // F3: \033[13~
-                    if (c4 == '4') { getchar(); return KEY_F4; }  // F4: \033[14~
-                    if (c4 == '5') { getchar(); return KEY_F5; }  // F5: \033[15~
-                    if (c4 == '7') { getchar(); return KEY_F6; }  // F6: \033[17~
-                    if (c4 == '8') { getchar(); return KEY_F7; }  // F7: \033[18~
-                    if (c4 == '9') { getchar(); return KEY_F8; }  // F8: \033[19~
-                } else if (c3 == '2') {
-                    if (c4 == '0') { getchar(); return KEY_F9; }  // F9: \033[20~
-                    if (c4 == '1') { getchar(); return KEY_F10; } // F10: \033[21~
-                    if (c4 == '~') { return KEY_INSERT; } // F10: \033[21~
-                }
+uint64_t str2u64(const char* s, uint64_t max, uint64_t def) {
+    char* endptr;
+    errno = 0;
+    uintmax_t x = strtoumax(s, &endptr, 10);
+    if (errno  == ERANGE) return def;
+    if (x > max) return def;
+    return x;
+}
+
+// Keys are parsed from a buffer filled by read(2) with whatever the tty has,
+// so a paste costs one syscall per buffer instead of one per byte. stdin is
+// not made O_NONBLOCK: on a tty it shares the open file with stdout.
+
+#define INPUT_BUF 4096
+
+static unsigned char input[INPUT_BUF];
+static size_t input_head, input_tail;
+static bool input_nowait, input_short;
+static struct charbuf* paste;
+
+// Waits up to timeout_ms (-1 forever) for more input and appends it;
+// false on timeout, signal or EOF.
+
+static bool input_fill(int timeout_ms) {
+    if (input_head > 0) {
+        memmove(input, input + input_head, input_tail - input_head);
+        input_tail -= input_head;
+        input_head = 0;
+    }
+    if (input_tail == INPUT_BUF) return false;
+    struct pollfd fd = { STDIN_FILENO, POLLIN, 0 };
+    if (poll(&fd, 1, timeout_ms) <= 0) return false;
+    ssize_t n = read(STDIN_FILENO, input + input_tail, INPUT_BUF - input_tail);
+    if (n <= 0) return false;
+    input_tail += n;
+    return true;
+}
+
+// Byte i of the pending input; a continuation byte is waited for at most
+// ESC_TIMEOUT_MS, after which the sequence is taken as ended. In nowait
+// mode a missing byte marks the key as short instead.
+
+static int input_peek(size_t i) {
+    while (input_head + i >= input_tail)
+        if (!input_fill(input_nowait ? 0 : ESC_TIMEOUT_MS)) {
+            if (input_nowait) input_short = true;
+            return -1;
+        }
+    return input[input_head + i];
+}
+
+static int csi_key(int param, int mod, int final) {
+    if (final == '~') {
+        switch (param) {
+            case 200: return KEY_PASTE; // \033[200~ text \033[201~
+            case 2:  return KEY_INSERT;
+            case 3:  return KEY_DELETE;
+            case 5:  return KEY_PGUP;
+            case 6:  return KEY_PGDOWN;
+            case 11: return KEY_F1;
+            case 12: return KEY_F2;
+            case 13: return KEY_F3;
+            case 14: return KEY_F4;
+            case 15: return KEY_F5;
+            case 17: return KEY_F6;
+            case 18: return KEY_F7;
+            case 19: return KEY_F8;
+            case 20: return KEY_F9;
+            case 21: return KEY_F10;
+        }
+        return KEY_ESC;
+    }
+    if (mod == 5 && final == 'D') return KEY_CTRL_LEFT;  // \033[1;5D
+    if (mod == 5 && final == 'C') return KEY_CTRL_RIGHT; // \033[1;5C
+    if (mod == 2 && final == 'D') return KEY_SHIFT_LEFT;  // \033[1;2D
+    if (mod == 2 && final == 'C') return KEY_SHIFT_RIGHT; // \033[1;2C
+    if (mod > 1) return KEY_ESC;
+    switch (final) {
+        case 'A': return KEY_UP;
+        case 'B': return KEY_DOWN;
+        case 'C': return KEY_RIGHT;
+        case 'D': return KEY_LEFT;
+        case 'H': return KEY_HOME;
+        case 'F': return KEY_END;
+    }
+    return KEY_ESC;
+}
+
+// Parses the escape sequence at the head of the input and returns its key
+// and length in *used. A sequence cut short by the timeout is consumed as
+// a lone Esc so its tail is not read as typed keys.
+
+static int escape_key(size_t* used) {
+    int c2 = input_peek(1);
+    *used = 1;
+    if (c2 == -1) return KEY_ESC; // одиночний Esc
+    if (c2 == '[') {
+        int param = 0, mod = 0, c;
+        bool semi = false;
+        size_t i = 2;
+        while ((c = input_peek(i)) != -1 && c >= 0x20 && c <= 0x3F) {
+            if (c == ';') semi = true;
+            else if (c >= '0' && c <= '9') {
+                if (semi) mod = mod * 10 + c - '0';
+                else param = param * 10 + c - '0';
             }
-        } else if (c2 == 'O') {
-            int c3 = getchar();
-            if (c3 == 'P') return KEY_F1;   // F1: \033OP
-            if (c3 == 'Q') return KEY_F2;   // F2: \033OQ
-            if (c3 == 'R') return KEY_F3;   // F3: \033OR
-            if (c3 == 'S') return KEY_F4;   // F4: \033OS
-        } else if (c2 >= 'A' && c2 <= 'Z') { // ESC + Shift
-            int c3 = getchar();
-            if (c2 == 'E' && c3 == '\n') return KEY_ESC_SHIFT_ENTER; // ESC+Shift+Enter
-            if (c2 == '[') return KEY_ESC_SHIFT_LEFT_BRACKET; // ESC+Shift+[
-            if (c2 == ']') return KEY_ESC_SHIFT_RIGHT_BRACKET; // ESC+Shift+]
-        } else if (c2 == 27) {
-            return KEY_ESC; // Esc
-        } else {
-            ungetc(c2, stdin); // Повернути символ назад
-            return KEY_ESC;
+            i++;
+        }
+        *used = c == -1 ? i : i + 1;
+        if (c == -1 || c < 0x40 || c > 0x7E) return KEY_ESC;
+        return csi_key(param, mod, c);
+    }
+    if (c2 == 'O') {
+        int c3 = input_peek(2);
+        *used = c3 == -1 ? 2 : 3;
+        if (c3 == 'P') return KEY_F1;   // F1: \033OP
+        if (c3 == 'Q') return KEY_F2;   // F2: \033OQ
+        if (c3 == 'R') return KEY_F3;   // F3: \033OR
+        if (c3 == 'S') return KEY_F4;   // F4: \033OS
+        return KEY_ESC;
+    }
+    if (c2 >= 'A' && c2 <= 'Z') { // ESC + Shift
+        int c3 = input_peek(2);
+        *used = c3 == -1 ? 2 : 3;
+        if (c2 == 'E' && c3 == '\n') return KEY_ESC_SHIFT_ENTER; // ESC+Shift+Enter
+        return KEY_ESC;
+    }
+    if (c2 == 27) *used = 2;
+    return KEY_ESC; // anything else is left to be read as the next key
+}
+
+static int parse_key(size_t* used) {
+    int c = input[input_head];
+    *used = 1;
+    if (c == 27) c = escape_key(used);
+    switch (c) {
+        case '\n': return KEY_ENTER;
+        case 9:    return KEY_TAB;
+        case 15:   return KEY_CTRL_O;
+        case 127:  return KEY_BACKSPACE;
+    }
+    return c;
+}
+
+// Moves everything up to the end of a bracketed paste into the paste
+// buffer. The text is taken as is; a terminal that never closes the paste
+// ends it after PASTE_TIMEOUT_MS of silence.
+
+static void paste_collect() {
+    static const char end[] = "\x1b[201~";
+    const size_t n = sizeof(end) - 1;
+    if (paste == NULL) paste = charbuf_create();
+    charbuf_reset(paste);
+    while (true) {
+        const unsigned char* base = input + input_head;
+        size_t avail = input_tail - input_head;
+        const unsigned char* m = memmem(base, avail, end, n);
+        if (m != NULL) {
+            charbuf_append(paste, (const char*) base, m - base);
+            input_head += m - base + n;
+            return;
+        }
+        size_t keep = avail < n - 1 ? avail : n - 1;
+        charbuf_append(paste, (const char*) base, avail - keep);
+        input_head += avail - keep;
+        if (!input_fill(PASTE_TIMEOUT_MS)) {
+            charbuf_append(paste, (const char*) input + input_head, input_tail - input_head);
+            input_head = input_tail;
+            return;
         }
-    } else if (c == '\n') {
-        return KEY_ENTER;
-    } else if (c == 9) {
-        return KEY_TAB;
-    } else if (c == 15) {
-        return KEY_CTRL_O;
-    } else if (c == 127) {
-        return KEY_BACKSPACE;
     }
+}
+
+const char* paste_text(size_t* len) {
+    *len = paste ? paste->len : 0;
+    return *len ? paste->contents : "";
+}
+
+// Returns the next key, waiting for one; -1 when a signal or EOF came first.
+
+int read_key() {
+    if (input_head == input_tail && !input_fill(-1)) return -1;
+    size_t used;
+    int c = parse_key(&used);
+    input_head += used;
+    if (c == KEY_PASTE) paste_collect();
     return c;
 }
 
+// Returns the next key without consuming it, if it has fully arrived;
+// -1 otherwise. Never waits.
+
+int peek_key() {
+    if (input_head == input_tail && !input_fill(0)) return -1;
+    size_t used;
+    input_nowait = true;
+    input_short = false;
+    int c = parse_key(&used);
+    input_nowait = false;
+    return input_short ? -1 : c;
+}
+
+// False, leaving rows and cols alone, when stdout is not a terminal.
+
 bool get_window_size(int* rows, int* cols) {
     struct winsize ws;
-    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) != 0) {
-        perror("Failed to query terminal size");
-        exit(1);
-    }
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) != 0 || ws.ws_row == 0) return false;
 
     *rows = ws.ws_row;
     *cols = ws.ws_col;
@@ -178,17 +312,27 @@ void enable_raw_mode() {
         perror("Unable to set terminal to raw mode");
         exit(1);
     }
+
+    // Bracketed paste: pasted text arrives as one KEY_PASTE.
+    (void) (write(STDOUT_FILENO, "\x1b[?2004h", 8) + 1);
+}
+
+bool key_pending(int timeout_ms) {
+    if (input_head < input_tail) return true;
+    struct pollfd fd = { STDIN_FILENO, POLLIN, 0 };
+    return poll(&fd, 1, timeout_ms) > 0;
 }
 
 void disable_raw_mode() {
     tcsetattr(STDIN_FILENO, TCSAFLUSH, &orig_termios);
-    (void) (write(STDOUT_FILENO, "\x1b[?25h", 6) + 1);
+    (void) (write(STDOUT_FILENO, "\x1b[?2004l\x1b[?25h", 14) + 1);
 }
 
 void clear_screen() {
     char stuff[80];
     int bw = snprintf(stuff, 80, "\x1b[0m\x1b[H\x1b[2J");
-    if (write(STDOUT_FILENO, stuff, bw) == -1) {
+    if (write_all(STDOUT_FILENO, stuff, bw) == -1) {
         perror("Unable to clear screen");
     }
+    screen_invalidate();
 }
@@ -5,7 +5,12 @@
 #define XT_RELEASE_DATE "2.5.2023"
 #define XT_VERSION "1.5.0"
 
+#define ESC_TIMEOUT_MS 50
+#define PASTE_TIMEOUT_MS 1000
+
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 #include <termios.h>
 
 enum key_codes {
@@ -50,7 +55,8 @@ enum key_codes {
     KEY_SHIFT_ENTER,
     KEY_ESC_SHIFT_ENTER,
     KEY_ESC_SHIFT_LEFT_BRACKET,
-    KEY_ESC_SHIFT_RIGHT_BRACKET
+    KEY_ESC_SHIFT_RIGHT_BRACKET,
+    KEY_PASTE     // bracketed paste, text in paste_text()
 };
 
 enum parse_errors {
@@ -59,6 +65,7 @@ enum parse_errors {
     PARSE_INCOMPLETE_HEX,        // "...\x" or "...\xA"
     PARSE_INVALID_HEX,           // "...\xXY..." and X or Y not in [a-zA-Z0-9]
     PARSE_INVALID_ESCAPE,        // "...\a..." and a is not '\' or 'x'
+    PARSE_INVALID_GAP,           // "...\[n-m..." malformed, leading or trailing gap
 };
 
 void term_state_save();
@@ -67,6 +74,9 @@ void enable_raw_mode();
 void disable_raw_mode();
 void clear_screen();
 int  read_key();
+int  peek_key();
+const char* paste_text(size_t* len);
+bool key_pending(int timeout_ms);
 int  hex2bin(const char* s);
 void gotoxy(int rows, int cols);
 bool get_window_size(int* rows, int* cols);
@@ -75,5 +85,7 @@ bool is_hex(const char* s);
 int hex2int(const char* s);
 int clampi(int i, int min, int max);
 int str2int(const char* s, int min, int max, int def);
+uint64_t hex2u64(const char* s);
+uint64_t str2u64(const char* s, uint64_t max, uint64_t def);
 
 #endif